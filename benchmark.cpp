@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ordered_adapter.hpp"
+#include "key_scan.hpp"
+#include "snapshot.hpp"
+#include "workload.hpp"
+
+namespace
+{
+    using namespace ds_exp;
+
+    void report(std::ostream &out, char const *name, latency_summary const &summary)
+    {
+        out << "  " << name << ": " << summary << ", mean "
+            << (summary.calls ? summary.total_nanoseconds / summary.calls : 0) << "ns\n";
+    }
+
+    struct large_value
+    {
+        static inline std::size_t copies = 0;
+        std::vector<char> payload;
+
+        large_value() = default;
+        large_value(large_value const &src)
+            : payload(src.payload)
+        {
+            ++copies;
+        }
+        large_value(large_value &&) = default;
+        large_value &operator=(large_value const &src)
+        {
+            payload = src.payload;
+            ++copies;
+            return *this;
+        }
+        large_value &operator=(large_value &&) = default;
+        friend std::istream &operator>>(std::istream &in, large_value &v)
+        {
+            std::size_t size = 0;
+            if (in >> size)
+                v.payload.assign(size, 'x');
+            return in;
+        }
+    };
+
+    void benchmark_create(std::ostream &out)
+    {
+        constexpr std::size_t nodes = 2000, payload = 16384, rounds = 20;
+        std::string definition = "[";
+        for (std::size_t i = 0; i < nodes; ++i)
+            definition += "(" + std::to_string(payload) + "),null,";
+        definition += "null]";
+        tree_adapter<large_value> adapter;
+        out << "CreateBiTree and InsertChild with " << payload << "-byte values, " << nodes << " nodes\n";
+        large_value::copies = 0;
+        report(out, "CreateBiTree", measure_latency(rounds, [&](std::size_t)
+        {
+            adapter.CreateBiTree(definition);
+        }));
+        out << "  copies of T while creating: " << large_value::copies << "\n";
+        large_value::copies = 0;
+        report(out, "InsertChild", measure_latency(rounds, [&](std::size_t)
+        {
+            tree_adapter<large_value> inserted;
+            inserted.CreateBiTree("[(" + std::to_string(payload) + "),null,null]");
+            adapter.InsertChild(adapter.Root(), std::move(inserted), left_child);
+        }));
+        out << "  copies of T while inserting: " << large_value::copies << "\n";
+        large_value::copies = 0;
+        report(out, "copy of the tree", measure_latency(1, [&](std::size_t)
+        {
+            auto copy = adapter;
+        }));
+        out << "  copies of T for one copy of the tree: " << large_value::copies << "\n";
+    }
+
+    template <typename T, typename Parse>
+    void report_parse(std::ostream &out, char const *name, std::vector<std::string> const &texts, Parse parse)
+    {
+        constexpr std::size_t batch = 1000;
+        T sink{};
+        auto summary = measure_latency(texts.size() / batch, [&](std::size_t i)
+        {
+            for (std::size_t j = i * batch; j < (i + 1) * batch; ++j)
+            {
+                T value;
+                parse(texts[j], value);
+                sink += value;
+            }
+        });
+        out << "  " << name << ": " << static_cast<double>(summary.total_nanoseconds) / (summary.calls * batch)
+            << "ns per element (sum " << sink << ")\n";
+    }
+
+    void benchmark_parse(std::ostream &out)
+    {
+        constexpr std::size_t elements = 100000, nodes = 20000;
+        std::mt19937_64 random(1);
+        std::vector<std::string> integers, reals;
+        for (std::size_t i = 0; i < elements; ++i)
+        {
+            integers.push_back(std::to_string(static_cast<int>(random() % 2000001) - 1000000));
+            reals.push_back(std::to_string(static_cast<double>(random() % 1000000) / 1000));
+        }
+        out << "element conversion, " << elements << " elements\n";
+        report_parse<int>(out, "int, element_parser", integers, [](std::string const &text, int &value)
+        {
+            element_parser<int>::parse(text, value);
+        });
+        report_parse<int>(out, "int, istringstream", integers, [](std::string const &text, int &value)
+        {
+            ds_exp::parse::detail::stream_assign(text, value);
+        });
+        report_parse<double>(out, "double, element_parser", reals, [](std::string const &text, double &value)
+        {
+            element_parser<double>::parse(text, value);
+        });
+        report_parse<double>(out, "double, istringstream", reals, [](std::string const &text, double &value)
+        {
+            ds_exp::parse::detail::stream_assign(text, value);
+        });
+
+        std::string definition = "[";
+        for (std::size_t i = 0; i < nodes; ++i)
+            definition += "(" + integers[i] + "," + reals[i] + "),null,";
+        definition += "null]";
+        tree_adapter<int, double> adapter;
+        auto summary = measure_latency(5, [&](std::size_t)
+        {
+            adapter.CreateBiTree(definition);
+        });
+        out << "  CreateBiTree<int, double>: " << static_cast<double>(summary.total_nanoseconds) / (summary.calls * nodes)
+            << "ns per node\n";
+    }
+
+    void benchmark_key_scan(std::ostream &out)
+    {
+        constexpr std::size_t nodes = 10000, lookups = 20000;
+        std::string definition = "[";
+        for (std::size_t i = 0; i < nodes; ++i)
+            definition += "(key " + std::to_string(i) + "," + std::to_string(i) + "),null,";
+        definition += "null]";
+        tree_adapter<std::string, int> adapter;
+        adapter.CreateBiTree(definition);
+        std::mt19937_64 random(1);
+        std::vector<std::string> keys;
+        for (std::size_t i = 0; i < lookups; ++i)
+            keys.push_back("key " + std::to_string(random() % nodes));
+        long long sum = 0;
+        out << "Value lookups of string keys, " << nodes << " nodes\n";
+        report(out, "linear walk", measure_latency(lookups, [&](std::size_t i)
+        {
+            sum += *adapter.TryValue<inorder_t>(keys[i]);
+        }));
+        report(out, "fingerprint cache", measure_latency(lookups, [&](std::size_t i)
+        {
+            sum += *adapter.TryValue(keys[i]);
+        }));
+        auto scan = adapter.KeyScan();
+        report(out, "key_scan", measure_latency(lookups, [&](std::size_t i)
+        {
+            sum += scan.find(keys[i])->value;
+        }));
+        report(out, "KeyScan build", measure_latency(10, [&](std::size_t)
+        {
+            sum += static_cast<long long>(adapter.KeyScan().size());
+        }));
+        out << "  sum " << sum << "\n";
+    }
+
+    void benchmark_snapshot(std::ostream &out)
+    {
+        constexpr std::size_t nodes = 300000, rounds = 5;
+        std::string definition = "[";
+        ds_exp::workload::detail::balanced_definition(definition, 0, nodes);
+        definition += "]";
+        tree_adapter<std::string> adapter, loaded;
+        adapter.CreateBiTree(definition);
+        std::string text, snapshot;
+        out << "save and load of a " << nodes << "-node tree\n";
+        report(out, "text save", measure_latency(rounds, [&](std::size_t)
+        {
+            std::ostringstream saved;
+            saved << adapter;
+            text = saved.str();
+        }));
+        report(out, "text load", measure_latency(rounds, [&](std::size_t)
+        {
+            std::istringstream saved(text);
+            saved >> loaded;
+        }));
+        report(out, "snapshot save", measure_latency(rounds, [&](std::size_t)
+        {
+            std::ostringstream saved;
+            save_snapshot(saved, adapter);
+            snapshot = saved.str();
+        }));
+        report(out, "decode, then parse", measure_latency(rounds, [&](std::size_t)
+        {
+            std::istringstream saved(snapshot);
+            std::istringstream decoded(read_snapshot(saved));
+            decoded >> loaded;
+        }));
+        std::vector<unsigned> thread_counts{1};
+        if (default_concurrency() > 1)
+            thread_counts.push_back(default_concurrency());
+        for (auto threads : thread_counts)
+        {
+            auto name = "streaming load, " + std::to_string(threads) + " threads";
+            report(out, name.c_str(), measure_latency(rounds, [&](std::size_t)
+            {
+                std::istringstream saved(snapshot);
+                load_snapshot(saved, loaded, threads);
+            }));
+        }
+        out << "  text " << text.size() << " bytes, snapshot " << snapshot.size() << " bytes, loaded "
+            << (loaded == adapter ? "equal" : "different") << "\n";
+    }
+
+    void benchmark_crc32c(std::ostream &out)
+    {
+        constexpr std::size_t bytes = std::size_t(1) << 24, rounds = 20, nodes = 300000;
+        std::mt19937_64 random(1);
+        std::string data(bytes, '\0');
+        for (auto &c : data)
+            c = static_cast<char>(random());
+        std::uint32_t sink = 0;
+        auto throughput = [&](char const *name, auto checksum)
+        {
+            auto summary = measure_latency(rounds, [&](std::size_t)
+            {
+                sink ^= checksum();
+            });
+            out << "  " << name << ": " << static_cast<double>(bytes) * summary.calls / summary.total_nanoseconds
+                << " GB/s\n";
+        };
+        out << "crc32c over " << bytes << " bytes\n";
+        throughput("crc32c", [&]
+        {
+            return crc32c(data);
+        });
+        throughput("software", [&]
+        {
+            return ~ds_exp::checksum::detail::crc32c_software(~0u, reinterpret_cast<unsigned char const *>(data.data()),
+                                                              data.size());
+        });
+
+        std::string definition = "[";
+        ds_exp::workload::detail::balanced_definition(definition, 0, nodes);
+        definition += "]";
+        tree_adapter<std::string> adapter, loaded;
+        adapter.CreateBiTree(definition);
+        std::ostringstream saved;
+        save_snapshot(saved, adapter);
+        auto snapshot = saved.str();
+        auto load = measure_latency(5, [&](std::size_t)
+        {
+            std::istringstream in(snapshot);
+            load_snapshot(in, loaded, 1);
+        });
+        auto verify = measure_latency(5, [&](std::size_t)
+        {
+            sink ^= crc32c(snapshot);
+        });
+        out << "  checksums of a " << snapshot.size() << "-byte snapshot: " << verify.total_nanoseconds / verify.calls
+            << "ns of a " << load.total_nanoseconds / load.calls << "ns load ("
+            << 100.0 * verify.total_nanoseconds / load.total_nanoseconds << "%), sink " << sink << "\n";
+    }
+
+    void benchmark_splay(std::ostream &out)
+    {
+        constexpr std::size_t keys = 50000, operations = 200000;
+        std::stringstream trace;
+        generate_trace(trace, workload_shape::zipf, operations, keys);
+        std::vector<std::size_t> lookups;
+        for (auto &key : trace_keys(trace))
+            lookups.push_back(std::stoul(key));
+        std::vector<std::size_t> sorted(keys);
+        std::iota(sorted.begin(), sorted.end(), std::size_t(0));
+        auto plain = ordered_tree_adapter<std::size_t>::from_sorted(sorted.begin(), sorted.end());
+        auto splayed = ordered_tree_adapter<std::size_t, null_value_tag, splay_access_t>::from_sorted(sorted.begin(),
+                                                                                                    sorted.end());
+        std::size_t found = 0;
+        out << "zipf Value lookups, " << keys << " keys, " << lookups.size() << " lookups\n";
+        report(out, "ordered plain", measure_latency(lookups.size(), [&](std::size_t i)
+        {
+            found += plain.Contains(lookups[i]);
+        }));
+        report(out, "ordered splay", measure_latency(lookups.size(), [&](std::size_t i)
+        {
+            found += splayed.Contains(lookups[i]);
+        }));
+        trace.clear();
+        trace.seekg(0);
+        tree_adapter<std::string> linear;
+        auto replayed = replay_trace(trace, linear);
+        report(out, "tree_adapter replay", replayed.operations[static_cast<std::size_t>(operation::Value)]);
+        out << "  found " << found << " of " << 2 * lookups.size() << "\n";
+    }
+
+    void benchmark_miss(std::ostream &out)
+    {
+        constexpr std::size_t keys = 1000, operations = 100000;
+        std::stringstream trace;
+        generate_trace(trace, workload_shape::uniform, operations, keys, 1, 0.3);
+        tree_adapter<std::string> adapter;
+        auto replayed = replay_trace(trace, adapter);
+        trace.clear();
+        trace.seekg(0);
+        std::vector<std::string> hits, misses;
+        for (auto &key : trace_keys(trace))
+            (std::stoul(key) < keys ? hits : misses).push_back(key);
+        std::size_t found = 0;
+        out << "Value lookups with a 30% miss ratio, " << keys << " keys, " << replayed.failures << " of "
+            << replayed.records << " replayed records missed\n";
+        report(out, "replay Value", replayed.operations[static_cast<std::size_t>(operation::Value)]);
+        report(out, "TryValue hit", measure_latency(hits.size(), [&](std::size_t i)
+        {
+            found += adapter.TryValue(hits[i]) != nullptr;
+        }));
+        report(out, "TryValue miss", measure_latency(misses.size(), [&](std::size_t i)
+        {
+            found += adapter.TryValue(misses[i]) != nullptr;
+        }));
+        report(out, "Value miss, caught", measure_latency(misses.size(), [&](std::size_t i)
+        {
+            try
+            {
+                found += adapter.Value(misses[i]).size();
+            }
+            catch (decltype(adapter)::precondition_failed_to_satisfy const &)
+            {
+            }
+        }));
+        out << "  found " << found << " of " << hits.size() << "\n";
+    }
+
+    void benchmark_compaction(std::ostream &out)
+    {
+        constexpr std::size_t keys = 1000, operations = 20000, scans = 50;
+        std::stringstream grow, scan;
+        generate_trace(grow, workload_shape::insert_heavy, operations, keys);
+        trace_writer writer(scan);
+        trace_record record;
+        record.op = operation::Traverse;
+        record.arguments = {"in", "left"};
+        for (std::size_t i = 0; i < scans; ++i)
+            writer.write(record);
+        tree_adapter<std::string> adapter;
+        replay_trace(grow, adapter);
+        auto traverse = [&]
+        {
+            scan.clear();
+            scan.seekg(0);
+            return replay_trace(scan, adapter).operations[static_cast<std::size_t>(operation::Traverse)];
+        };
+        out << "inorder Traverse after an insert-heavy replay, " << adapter.BiTreeDepth() << " deep\n";
+        report(out, "scattered", traverse());
+        adapter.Compact(inorder);
+        report(out, "compacted", traverse());
+    }
+
+    struct benchmark
+    {
+        char const *name;
+        void (*run)(std::ostream &);
+    };
+    benchmark const benchmarks[] = {
+        {"create", benchmark_create},
+        {"parse", benchmark_parse},
+        {"splay", benchmark_splay},
+        {"miss", benchmark_miss},
+        {"key_scan", benchmark_key_scan},
+        {"snapshot", benchmark_snapshot},
+        {"crc32c", benchmark_crc32c},
+        {"compaction", benchmark_compaction},
+    };
+}
+
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i)
+        if (std::none_of(std::begin(benchmarks), std::end(benchmarks), [&](benchmark const &b)
+        {
+            return argv[i] == std::string(b.name);
+        }))
+        {
+            std::cerr << "usage: " << argv[0] << " [benchmark...]\nbenchmarks:";
+            for (auto &b : benchmarks)
+                std::cerr << " " << b.name;
+            std::cerr << std::endl;
+            return 2;
+        }
+    for (auto &b : benchmarks)
+        if (argc == 1 || std::any_of(argv + 1, argv + argc, [&](char const *name)
+        {
+            return name == std::string(b.name);
+        }))
+            b.run(std::cout);
+    return 0;
+}
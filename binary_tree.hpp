@@ -2,9 +2,18 @@
 #ifndef INC_201703_BINARY_TREE_HPP
 #define INC_201703_BINARY_TREE_HPP
 
+#include <algorithm>
 #include <cstdlib>
 #include <memory>
 #include <cassert>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "instrumentation.hpp"
 
 namespace ds_exp
 {
@@ -28,6 +37,14 @@ namespace ds_exp
         constexpr right_first_t right_first;
         constexpr right_t right_child;
 
+        struct precondition_failed_to_satisfy : std::logic_error
+        {
+            explicit precondition_failed_to_satisfy(std::string const &function)
+                : logic_error("The precondition of function " + function + " failed to satisfy.")
+            {
+            }
+        };
+
         template <typename T>
         struct node
         {
@@ -40,6 +57,18 @@ namespace ds_exp
             {
             }
 
+            template <typename ...Args>
+            explicit node(std::in_place_t, node *parent, Args &&...args)
+                :value(std::forward<Args>(args)...), parent(parent)
+            {
+            }
+#ifdef DS_EXP_INSTRUMENT
+            ~node()
+            {
+                DS_EXP_TRACE_DEALLOCATION(sizeof(node));
+            }
+#endif
+
             value_type value;
             std::unique_ptr<node> left_child;
             std::unique_ptr<node> right_child;
@@ -63,6 +92,16 @@ namespace ds_exp
             {
                 return p->right_child;
             }
+            template <typename T>
+            static auto &first_child(node<T> const *p)
+            {
+                return p->left_child;
+            }
+            template <typename T>
+            static auto &second_child(node<T> const *p)
+            {
+                return p->right_child;
+            }
         };
 
         template <>
@@ -79,6 +118,16 @@ namespace ds_exp
             {
                 return p->left_child;
             }
+            template <typename T>
+            static auto &first_child(node<T> const *p)
+            {
+                return p->right_child;
+            }
+            template <typename T>
+            static auto &second_child(node<T> const *p)
+            {
+                return p->left_child;
+            }
         };
 
         struct inorder_t
@@ -213,6 +262,31 @@ namespace ds_exp
             }
         };
 
+        template <typename iter>
+        class iterator_range
+        {
+        public:
+            iterator_range(iter first, iter last)
+                :first(first), last(last)
+            {
+            }
+
+            iter begin() const
+            {
+                return first;
+            }
+            iter end() const
+            {
+                return last;
+            }
+            bool empty() const
+            {
+                return first == last;
+            }
+        private:
+            iter first, last;
+        };
+
         template <typename T>
         class binary_tree
         {
@@ -233,12 +307,19 @@ namespace ds_exp
                 using reference = value_type &;
                 using iterator_category = std::bidirectional_iterator_tag;
 
-                template <typename iter1, typename iter2>
+                template <typename iter>
+                static node_type *node_of(iter const &i)
+                {
+                    return i.node;
+                }
+                template <typename iter1, typename iter2,
+                    std::enable_if_t<std::is_base_of_v<base_iter, iter1> && std::is_base_of_v<base_iter, iter2>, int> = 0>
                 friend bool operator==(iter1 const &lhs, iter2 const &rhs)
                 {
-                    return lhs.node == rhs.node;
+                    return node_of(lhs) == node_of(rhs);
                 }
-                template <typename iter1, typename iter2>
+                template <typename iter1, typename iter2,
+                    std::enable_if_t<std::is_base_of_v<base_iter, iter1> && std::is_base_of_v<base_iter, iter2>, int> = 0>
                 friend bool operator!=(iter1 const &lhs, iter2 const &rhs)
                 {
                     return !(lhs == rhs);
@@ -268,9 +349,10 @@ namespace ds_exp
                 {
                 }
 
-                const binary_tree *tree;
-                node_type *node;
+                const binary_tree *tree = nullptr;
+                node_type *node = nullptr;
             public:
+                const_iterator() = default;
 
                 template <typename order, typename direction>
                 const_iterator(const_iterator<order, direction> const &src)
@@ -347,8 +429,7 @@ namespace ds_exp
                 {
                     return const_iterator<order, direction>(*this);
                 }
-                template <typename iter1, typename iter2>
-                friend bool operator==(iter1 const &, iter2 const &);
+                friend struct base_iter;
             };
 
             template <typename default_order, typename default_direction>
@@ -361,9 +442,10 @@ namespace ds_exp
                 {
                 }
 
-                binary_tree *tree;
-                node_type *node;
+                binary_tree *tree = nullptr;
+                node_type *node = nullptr;
             public:
+                iterator() = default;
                 template <typename order = default_order, typename direction = default_direction>
                 iterator(iterator<order, direction> const &src)
                     :tree(src.tree), node(src.node)
@@ -445,12 +527,15 @@ namespace ds_exp
                     return iterator<order, direction>(*this);
                 }
 
-                template <typename iter1, typename iter2>
-                friend bool operator==(iter1 const &, iter2 const &);
+                friend struct base_iter;
             };
 
             binary_tree() = default;
-            binary_tree(binary_tree &&src) = default;
+            binary_tree(binary_tree &&src) noexcept
+                : root_(std::move(src.root_)), modifications_(src.modifications_)
+            {
+                ++src.modifications_;
+            }
             binary_tree(binary_tree const &src)
             {
                 set_root(*src.root());
@@ -462,7 +547,13 @@ namespace ds_exp
                         new_child(dest_iter, *src_iter.second_child(), default_direction::inverse{});
                 }
             }
-            binary_tree &operator=(binary_tree &&) = default;
+            binary_tree &operator=(binary_tree &&src) noexcept
+            {
+                root_ = std::move(src.root_);
+                modifications_ = std::max(modifications_, src.modifications_) + 1;
+                ++src.modifications_;
+                return *this;
+            }
             binary_tree &operator=(binary_tree const &src)
             {
                 *this = binary_tree(src);
@@ -503,6 +594,16 @@ namespace ds_exp
                 return get_const_iter<order_t, direction_t>(nullptr);
             }
             template <typename order_t = default_order, typename direction_t = default_direction>
+            auto position(node_type const *p, order_t = order_t{}, direction_t = direction_t{})
+            {
+                return get_iter<order_t, direction_t>(const_cast<node_type *>(p));
+            }
+            template <typename order_t = default_order, typename direction_t = default_direction>
+            auto position(node_type const *p, order_t = order_t{}, direction_t = direction_t{}) const
+            {
+                return get_const_iter<order_t, direction_t>(const_cast<node_type *>(p));
+            }
+            template <typename order_t = default_order, typename direction_t = default_direction>
             auto cend(order_t = order_t{}, direction_t = direction_t{}) const
             {
                 return get_const_iter<order_t, direction_t>(nullptr);
@@ -519,14 +620,52 @@ namespace ds_exp
                 return get_const_iter<order_t, direction_t>(root_.get());
             }
 
+            template <typename iter, typename order_t = default_order, typename direction_t = default_direction>
+            auto subtree(iter position, order_t order = order_t{}, direction_t direction = direction_t{})
+            {
+                using order_type = order_template<value_type, order_t, direction_t>;
+                if (!position.node)
+                    return iterator_range(end(order, direction), end(order, direction));
+                auto last = order_type::inverse_order::begin(position.node);
+                return iterator_range(get_iter<order_t, direction_t>(order_type::begin(position.node)),
+                                      get_iter<order_t, direction_t>(order_type::next(last)));
+            }
+            template <typename iter, typename order_t = default_order, typename direction_t = default_direction>
+            auto subtree(iter position, order_t order = order_t{}, direction_t direction = direction_t{}) const
+            {
+                using order_type = order_template<value_type, order_t, direction_t>;
+                if (!position.node)
+                    return iterator_range(end(order, direction), end(order, direction));
+                auto last = order_type::inverse_order::begin(position.node);
+                return iterator_range(get_const_iter<order_t, direction_t>(order_type::begin(position.node)),
+                                      get_const_iter<order_t, direction_t>(order_type::next(last)));
+            }
+
             void clear()
             {
+                ++modifications_;
                 root_.reset();
             }
             bool empty() const
             {
                 return root() == end();
             }
+            size_type size() const
+            {
+                return static_cast<size_type>(std::distance(begin(), end()));
+            }
+            node_type *root_node()
+            {
+                return root_.get();
+            }
+            node_type const *root_node() const
+            {
+                return root_.get();
+            }
+            std::size_t modification_count() const
+            {
+                return modifications_;
+            }
             std::size_t depth() const
             {
                 return subtree_depth(root());
@@ -543,6 +682,7 @@ namespace ds_exp
             template <typename iter>
             binary_tree replace(iter replaced, binary_tree &&new_tree)
             {
+                ++modifications_;
                 handler_type *handler = nullptr;
                 if (replaced == root())
                     handler = &root_;
@@ -551,6 +691,7 @@ namespace ds_exp
                 auto parent = (*handler)->parent;
                 auto returned = std::move(*handler);
                 *handler = std::move(new_tree.root_);
+                ++new_tree.modifications_;
                 if (*handler)
                     (*handler)->parent = parent;
                 return binary_tree(returned);
@@ -565,26 +706,196 @@ namespace ds_exp
             template <typename U>
             void set_root(U &&u)
             {
+                ++modifications_;
                 root_ = make_handler(std::forward<U>(u), nullptr);
             }
             template <typename direction, typename iter, typename U>
             iter new_child(iter parent, U &&u, direction = direction{})
             {
+                ++modifications_;
                 auto &child = iterate_direction<direction>::first_child(parent.node);
                 child = make_handler(std::forward<U>(u), parent.node);
                 return iter(this, child.get());
             }
+            template <typename ...Args>
+            void emplace_root(Args &&...args)
+            {
+                ++modifications_;
+                DS_EXP_TRACE_ALLOCATION(sizeof(node_type));
+                root_ = std::make_unique<node_type>(std::in_place, nullptr, std::forward<Args>(args)...);
+            }
+            template <typename iter, typename ...Args>
+            iter emplace_child(iter parent, Args &&...args)
+            {
+                auto arguments = std::forward_as_tuple(std::forward<Args>(args)...);
+                using direction = std::decay_t<std::tuple_element_t<sizeof...(Args) - 1, decltype(arguments)>>;
+                static_assert(std::is_same_v<direction, left_first_t> || std::is_same_v<direction, right_first_t>,
+                              "emplace_child takes the direction as its last argument");
+                return emplace_child<direction>(parent, arguments, std::make_index_sequence<sizeof...(Args) - 1>{});
+            }
             template <typename iter, typename direction_t>
             binary_tree replace_child(iter parent, binary_tree &&tree, direction_t = direction_t{})
             {
+                ++modifications_;
                 auto &child = iterate_direction<direction_t>::first_child(parent.node);
                 auto replaced = std::move(child);
                 child = std::move(tree.root_);
+                ++tree.modifications_;
                 if (child)
                     child->parent = parent.node;
                 return binary_tree(std::move(replaced));
             }
 
+            // Checking that attach belongs to one of the trees and lies outside the displaced subtree walks
+            // from attach to its root, so splice costs O(depth of attach); the relinking itself is O(1).
+            template <typename iter, typename attach_iter, typename child_t, typename attach_t>
+            void splice(iter parent, binary_tree &&inserted, child_t, attach_iter attach, attach_t)
+            {
+                auto &child = iterate_direction<child_t>::first_child(parent.node);
+                if (!attach.node || iterate_direction<attach_t>::first_child(attach.node))
+                    throw precondition_failed_to_satisfy(__func__);
+                auto top = attach.node;
+                for (; top->parent; top = top->parent)
+                    if (top == child.get())
+                        throw precondition_failed_to_satisfy(__func__);
+                if (top == child.get() || (top != inserted.root_.get() && top != root_.get()))
+                    throw precondition_failed_to_satisfy(__func__);
+                ++modifications_;
+                auto displaced = std::move(child);
+                child = std::move(inserted.root_);
+                ++inserted.modifications_;
+                if (child)
+                    child->parent = parent.node;
+                if (!displaced)
+                    return;
+                auto &slot = iterate_direction<attach_t>::first_child(attach.node);
+                slot = std::move(displaced);
+                if (slot)
+                    slot->parent = attach.node;
+            }
+
+            template <typename iter>
+            void rotate_up(iter target)
+            {
+                ++modifications_;
+                auto x = target.node;
+                assert(x && x->parent);
+                auto p = x->parent, g = p->parent;
+                auto &slot = g ? get_handler(p) : root_;
+                bool left = p->left_child.get() == x;
+                auto &inner = left ? p->left_child : p->right_child;
+                auto &outer = left ? x->right_child : x->left_child;
+                auto lifted = std::move(inner);
+                inner = std::move(outer);
+                if (inner)
+                    inner->parent = p;
+                outer = std::move(slot);
+                p->parent = x;
+                slot = std::move(lifted);
+                x->parent = g;
+            }
+            template <typename iter>
+            iter relocate(iter target, std::vector<handler_type> &retired)
+            {
+                ++modifications_;
+                auto x = target.node;
+                assert(x);
+                auto &slot = x->parent ? get_handler(x) : root_;
+                auto fresh = make_handler(std::move(x->value), x->parent, std::move(x->left_child), std::move(x->right_child));
+                if (fresh->left_child)
+                    fresh->left_child->parent = fresh.get();
+                if (fresh->right_child)
+                    fresh->right_child->parent = fresh.get();
+                retired.push_back(std::exchange(slot, std::move(fresh)));
+                return iter(this, slot.get());
+            }
+            template <typename iter>
+            void splay(iter target)
+            {
+                auto x = target.node;
+                assert(x);
+                while (auto p = x->parent)
+                {
+                    auto g = p->parent;
+                    if (g && (p->left_child.get() == x) == (g->left_child.get() == p))
+                        rotate_up(iter(this, p));
+                    else if (g)
+                        rotate_up(iter(this, x));
+                    rotate_up(iter(this, x));
+                }
+            }
+
+            template <typename Iter>
+            static binary_tree from_sorted(Iter first, Iter last)
+            {
+                auto size = static_cast<size_type>(std::distance(first, last));
+                return binary_tree(build_balanced(first, size));
+            }
+            template <typename Iter>
+            static binary_tree from_level_order(Iter first, Iter last)
+            {
+                if (first == last || !*first)
+                    return binary_tree{};
+                binary_tree tree;
+                tree.root_ = make_handler(**first);
+                std::vector<node_type *> pending;
+                if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<Iter>::iterator_category>)
+                    pending.reserve(static_cast<size_type>(std::distance(first, last)));
+                pending.push_back(tree.root_.get());
+                size_type head = 0;
+                bool left = true;
+                for (++first; first != last; ++first)
+                {
+                    if (head == pending.size())
+                        throw precondition_failed_to_satisfy(__func__);
+                    auto parent = pending[head];
+                    auto &child = left ? parent->left_child : parent->right_child;
+                    if (*first)
+                    {
+                        child = make_handler(**first, parent);
+                        pending.push_back(child.get());
+                    }
+                    if (!left)
+                        ++head;
+                    left = !left;
+                }
+                return tree;
+            }
+            template <typename ValueIter, typename ShapeIter>
+            static binary_tree from_preorder(ValueIter value, ValueIter value_end, ShapeIter shape, ShapeIter shape_end)
+            {
+                if (shape == shape_end || !*shape++)
+                    return binary_tree{};
+                if (value == value_end)
+                    throw precondition_failed_to_satisfy(__func__);
+                binary_tree tree;
+                tree.root_ = make_handler(*value++);
+                std::vector<std::pair<node_type *, bool>> stack;
+                stack.emplace_back(tree.root_.get(), true);
+                for (; shape != shape_end; ++shape)
+                {
+                    if (stack.empty())
+                        throw precondition_failed_to_satisfy(__func__);
+                    auto &[parent, left] = stack.back();
+                    auto &child = left ? parent->left_child : parent->right_child;
+                    auto parent_node = parent;
+                    if (left)
+                        left = false;
+                    else
+                        stack.pop_back();
+                    if (*shape)
+                    {
+                        if (value == value_end)
+                            throw precondition_failed_to_satisfy(__func__);
+                        child = make_handler(*value++, parent_node);
+                        stack.emplace_back(child.get(), true);
+                    }
+                }
+                if (!stack.empty() || value != value_end)
+                    throw precondition_failed_to_satisfy(__func__);
+                return tree;
+            }
+
             friend bool operator==(binary_tree const &lhs, binary_tree const &rhs)
             {
                 auto left_iter = lhs.begin(preorder), right_iter = rhs.begin(preorder);
@@ -614,12 +925,38 @@ namespace ds_exp
                 else
                     return p->parent->right_child;
             }
+            template <typename direction, typename iter, typename Tuple, std::size_t ...I>
+            iter emplace_child(iter parent, Tuple &arguments, std::index_sequence<I...>)
+            {
+                ++modifications_;
+                auto &child = iterate_direction<direction>::first_child(parent.node);
+                DS_EXP_TRACE_ALLOCATION(sizeof(node_type));
+                child = std::make_unique<node_type>(std::in_place, parent.node, std::get<I>(std::move(arguments))...);
+                return iter(this, child.get());
+            }
             template <typename U>
-            auto make_handler(U &&u, node_type *parent = nullptr, handler_type left = nullptr, handler_type right = nullptr)
+            static auto make_handler(U &&u, node_type *parent = nullptr, handler_type left = nullptr, handler_type right = nullptr)
             {
+                DS_EXP_TRACE_ALLOCATION(sizeof(node_type));
                 return std::make_unique<node_type>(std::forward<U>(u), parent, std::move(left), std::move(right));
             }
+            template <typename Iter>
+            static handler_type build_balanced(Iter &first, size_type size)
+            {
+                if (size == 0)
+                    return nullptr;
+                auto left = build_balanced(first, size / 2);
+                auto root = make_handler(*first, nullptr, std::move(left));
+                ++first;
+                root->right_child = build_balanced(first, size - size / 2 - 1);
+                if (root->left_child)
+                    root->left_child->parent = root.get();
+                if (root->right_child)
+                    root->right_child->parent = root.get();
+                return root;
+            }
             handler_type root_;
+            std::size_t modifications_ = 0;
         };
 
         template <typename tree_t, typename order_t, typename dir_t>
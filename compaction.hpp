@@ -0,0 +1,124 @@
+#ifndef INC_201703_COMPACTION_HPP
+#define INC_201703_COMPACTION_HPP
+
+#include <chrono>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "binary_tree.hpp"
+#include "resumable_traversal.hpp"
+
+namespace ds_exp
+{
+    inline namespace tree
+    {
+        template <typename tree_t, typename order_t = preorder_t, typename dir_t = left_first_t>
+        class tree_compaction
+        {
+            using iterator = decltype(std::declval<tree_t &>().begin(order_t{}, dir_t{}));
+
+        public:
+            explicit tree_compaction(tree_t &tree, order_t = order_t{}, dir_t = dir_t{}, bool track = false)
+                : tree(&tree), current(tree.begin(order_t{}, dir_t{})), modifications(tree.modification_count()),
+                  track(track)
+            {
+            }
+            tree_compaction(tree_compaction &&) = default;
+            tree_compaction &operator=(tree_compaction &&) = default;
+
+            bool resume(std::size_t budget)
+            {
+                for (; budget != 0 && !done(); --budget)
+                    step();
+                return done();
+            }
+            template <typename Rep, typename Period>
+            bool resume_for(std::chrono::duration<Rep, Period> slice, std::size_t stride = 64)
+            {
+                auto deadline = std::chrono::steady_clock::now() + slice;
+                while (!done())
+                {
+                    for (auto n = stride; n != 0 && !done(); --n)
+                        step();
+                    if (std::chrono::steady_clock::now() >= deadline)
+                        break;
+                }
+                return done();
+            }
+            void restart()
+            {
+                current = tree->begin(order_t{}, dir_t{});
+                modifications = tree->modification_count();
+            }
+
+            bool done() const
+            {
+                return !current;
+            }
+            bool valid() const
+            {
+                return modifications == tree->modification_count();
+            }
+            std::size_t relocated() const
+            {
+                return retired.size();
+            }
+
+            template <typename H>
+            iterator remap(H const &old) const
+            {
+                if (!old)
+                    return iterator{};
+                void const *address;
+                if constexpr (std::is_pointer_v<H>)
+                    address = old;
+                else
+                    address = &*old;
+                auto found = moved.find(address);
+                return found == moved.end() ? iterator{} : found->second;
+            }
+            void release()
+            {
+                retired.clear();
+                moved.clear();
+            }
+
+        private:
+            void step()
+            {
+                if (!valid())
+                    throw traversal_invalidated();
+                auto old = &*current;
+                current = tree->relocate(current, retired);
+                if (track)
+                    moved.emplace(old, current);
+                ++current;
+                modifications = tree->modification_count();
+            }
+
+            tree_t *tree;
+            iterator current;
+            std::size_t modifications;
+            bool track;
+            std::vector<typename tree_t::handler_type> retired;
+            std::unordered_map<void const *, iterator> moved;
+        };
+
+        template <typename tree_t, typename order_t, typename dir_t = left_first_t>
+        auto make_tree_compaction(tree_t &tree, order_t order, dir_t dir = dir_t{}, bool track = false)
+        {
+            return tree_compaction<tree_t, order_t, dir_t>(tree, order, dir, track);
+        }
+        template <typename T, typename order_t = preorder_t, typename dir_t = left_first_t>
+        auto compact(binary_tree<T> &tree, order_t order = order_t{}, dir_t dir = dir_t{}, bool track = false)
+        {
+            auto compaction = make_tree_compaction(tree, order, dir, track);
+            compaction.resume(std::numeric_limits<std::size_t>::max());
+            return compaction;
+        }
+    }
+}
+
+#endif //INC_201703_COMPACTION_HPP
@@ -0,0 +1,408 @@
+#ifndef INC_201703_CONSOLE_UI_HPP
+#define INC_201703_CONSOLE_UI_HPP
+
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "tree_adapter.hpp"
+
+namespace ds_exp
+{
+    inline namespace ui
+    {
+        struct batch_report
+        {
+            std::size_t commands = 0;
+            std::size_t failures = 0;
+            double seconds = 0;
+
+            double operations_per_second() const
+            {
+                return seconds > 0 ? commands / seconds : 0;
+            }
+            friend std::ostream &operator<<(std::ostream &out, batch_report const &report)
+            {
+                return out << report.commands << " commands, " << report.failures << " failed, " << report.seconds
+                           << "s, " << report.operations_per_second() << " ops/s";
+            }
+        };
+
+        namespace detail
+        {
+            class command_line
+            {
+            public:
+                explicit command_line(std::string_view line)
+                    : rest(line)
+                {
+                }
+                std::string_view next()
+                {
+                    skip_blank();
+                    if (rest.empty())
+                        return {};
+                    std::size_t first = 0, last = 0;
+                    if (rest.front() == '(')
+                    {
+                        first = last = 1;
+                        while (last < rest.size() && (rest[last] != ')' || rest[last - 1] == '\\'))
+                            ++last;
+                        auto token = rest.substr(first, last - first);
+                        rest.remove_prefix(last < rest.size() ? last + 1 : last);
+                        return token;
+                    }
+                    while (last < rest.size() && !is_blank(rest[last]))
+                        ++last;
+                    auto token = rest.substr(0, last);
+                    rest.remove_prefix(last);
+                    return token;
+                }
+                std::string_view value()
+                {
+                    skip_blank();
+                    if (!rest.empty() && rest.front() == '(')
+                        return next();
+                    return remainder();
+                }
+                std::string_view remainder()
+                {
+                    skip_blank();
+                    while (!rest.empty() && is_blank(rest.back()))
+                        rest.remove_suffix(1);
+                    return std::exchange(rest, std::string_view{});
+                }
+
+            private:
+                static bool is_blank(char c)
+                {
+                    return c == ' ' || c == '\t' || c == '\r';
+                }
+                void skip_blank()
+                {
+                    while (!rest.empty() && is_blank(rest.front()))
+                        rest.remove_prefix(1);
+                }
+                std::string_view rest;
+            };
+
+            inline std::string_view unescape(std::string_view token, std::string &scratch)
+            {
+                if (token.find('\\') == std::string_view::npos)
+                    return token;
+                scratch.clear();
+                for (std::size_t pos = 0; pos < token.size(); ++pos)
+                {
+                    if (token[pos] == '\\' && pos + 1 < token.size() && token[pos + 1] == ')')
+                        ++pos;
+                    scratch.push_back(token[pos]);
+                }
+                return scratch;
+            }
+
+            template <typename T>
+            void append_text(std::string &out, T const &t, std::ostringstream &scratch)
+            {
+                if constexpr (std::is_convertible_v<T const &, std::string_view>)
+                    out.append(std::string_view(t));
+                else if constexpr (parse::detail::from_chars_convertible_v<T> && std::is_integral_v<T>)
+                {
+                    char digits[24];
+                    auto result = std::to_chars(digits, digits + sizeof digits, t);
+                    out.append(digits, result.ptr);
+                } else
+                {
+                    scratch.str(std::string{});
+                    scratch << t;
+                    out.append(scratch.str());
+                }
+            }
+        }
+
+        template <typename Key, typename Value = null_value_tag>
+        class console_ui
+        {
+        public:
+            using adapter_type = tree_adapter<Key, Value>;
+            using key_type = typename adapter_type::key_type;
+            using value_type = typename adapter_type::value_type;
+            using element_type = typename adapter_type::element_type;
+
+            void execute(std::istream &in = std::cin, std::ostream &out = std::cout)
+            {
+                std::string line, output;
+                out << "binary tree console, type help for commands\n";
+                while (out << "> " << std::flush && std::getline(in, line))
+                {
+                    output.clear();
+                    auto keep_running = execute_line(line, output);
+                    out << output << std::flush;
+                    if (!keep_running)
+                        break;
+                }
+            }
+
+            batch_report execute_batch(std::istream &in, std::ostream &out, std::size_t block_size = std::size_t(1) << 20)
+            {
+                batch_report report;
+                auto start = std::chrono::steady_clock::now();
+                std::vector<char> block(block_size ? block_size : 1);
+                std::string pending, output;
+                bool keep_running = true;
+                auto run = [&](std::string_view line)
+                {
+                    if (line.empty() || line.front() == '#')
+                        return;
+                    if (!execute_line(line, output))
+                    {
+                        keep_running = false;
+                        return;
+                    }
+                    ++report.commands;
+                    if (failed)
+                        ++report.failures;
+                    if (output.size() >= flush_threshold)
+                    {
+                        out.write(output.data(), static_cast<std::streamsize>(output.size()));
+                        output.clear();
+                    }
+                };
+                while (keep_running && in)
+                {
+                    in.read(block.data(), static_cast<std::streamsize>(block.size()));
+                    std::string_view chunk(block.data(), static_cast<std::size_t>(in.gcount()));
+                    if (chunk.empty())
+                        break;
+                    auto newline = chunk.find('\n');
+                    if (newline == std::string_view::npos)
+                    {
+                        pending.append(chunk);
+                        continue;
+                    }
+                    pending.append(chunk.substr(0, newline));
+                    run(pending);
+                    pending.clear();
+                    for (auto first = newline + 1; keep_running; first = newline + 1)
+                    {
+                        newline = chunk.find('\n', first);
+                        if (newline == std::string_view::npos)
+                        {
+                            pending.assign(chunk.substr(first));
+                            break;
+                        }
+                        run(chunk.substr(first, newline - first));
+                    }
+                }
+                if (keep_running && !pending.empty())
+                    run(pending);
+                out.write(output.data(), static_cast<std::streamsize>(output.size()));
+                report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                return report;
+            }
+
+            bool execute_line(std::string_view line, std::string &out)
+            {
+                failed = false;
+                detail::command_line args(line);
+                auto command = args.next();
+                try
+                {
+                    if (command.empty())
+                        return true;
+                    if (command == "quit" || command == "exit")
+                        return false;
+                    dispatch(command, args, out);
+                }
+                catch (std::exception const &e)
+                {
+                    fail(out, e.what());
+                }
+                return true;
+            }
+
+            adapter_type &adapter()
+            {
+                return tree;
+            }
+
+        private:
+            static constexpr std::size_t flush_threshold = std::size_t(1) << 16;
+
+            void dispatch(std::string_view command, detail::command_line &args, std::string &out)
+            {
+                if (command == "value")
+                {
+                    if (auto value = tree.TryValue(lookup(args.next())))
+                        append(out, *value).push_back('\n');
+                    else
+                        miss(out);
+                } else if (command == "assign")
+                {
+                    auto key = args.next();
+                    if (!tree.TryAssign(lookup(key), parse<value_type>(detail::unescape(args.value(), scratch_value))))
+                        miss(out);
+                } else if (command == "parent")
+                {
+                    if (auto position = find(args.next()); position && *position != tree.Root())
+                        print_position(out, std::optional(position->parent()));
+                    else
+                        print_position(out, position ? std::optional(tree.get_end_iterator()) : std::nullopt);
+                } else if (command == "child")
+                {
+                    auto position = find(args.next());
+                    if (!position)
+                        miss(out);
+                    else if (is_left(args.next()))
+                        print_position(out, std::optional(position->first_child(left_child)));
+                    else
+                        print_position(out, std::optional(position->first_child(right_child)));
+                } else if (command == "sibling")
+                {
+                    auto position = find(args.next());
+                    if (!position || *position == tree.Root())
+                        print_position(out, position ? std::optional(tree.get_end_iterator()) : std::nullopt);
+                    else
+                    {
+                        auto sibling = is_left(args.next()) ? position->parent().first_child(left_child)
+                                                            : position->parent().first_child(right_child);
+                        print_position(out, std::optional(sibling == *position ? tree.get_end_iterator() : sibling));
+                    }
+                } else if (command == "insert")
+                {
+                    auto position = find(args.next());
+                    auto left = is_left(args.next());
+                    adapter_type inserted;
+                    inserted.CreateBiTree(std::string(args.remainder()));
+                    if (!position)
+                        miss(out);
+                    else if (left)
+                        tree.InsertChild(*position, std::move(inserted), left_child);
+                    else
+                        tree.InsertChild(*position, std::move(inserted), right_child);
+                } else if (command == "delete")
+                {
+                    auto position = find(args.next());
+                    if (!position)
+                        miss(out);
+                    else if (is_left(args.next()))
+                        tree.DeleteChild(*position, left_child);
+                    else
+                        tree.DeleteChild(*position, right_child);
+                } else if (command == "traverse")
+                {
+                    auto order = args.next();
+                    auto print = [&](element_type const &element)
+                    {
+                        append_element(out, element).push_back(' ');
+                    };
+                    if (order == "in" || order == "inorder")
+                        tree.Traverse(print, inorder);
+                    else if (order == "post" || order == "postorder")
+                        tree.Traverse(print, postorder);
+                    else if (order == "level")
+                        tree.LevelOrderTraverse(print);
+                    else
+                        tree.Traverse(print, preorder);
+                    out.push_back('\n');
+                } else if (command == "create")
+                    tree.CreateBiTree(std::string(args.remainder()));
+                else if (command == "init")
+                    tree.InitBiTree();
+                else if (command == "destroy")
+                    tree.DestroyBiTree();
+                else if (command == "clear")
+                    tree.ClearBiTree();
+                else if (command == "empty")
+                    out.append(tree.BiTreeEmpty() ? "true\n" : "false\n");
+                else if (command == "depth")
+                    append(out, tree.BiTreeDepth()).push_back('\n');
+                else if (command == "root")
+                    print_position(out, std::optional(tree.Root()));
+                else if (command == "print")
+                {
+                    std::ostringstream stream;
+                    stream << tree;
+                    out.append(stream.str()).push_back('\n');
+                } else if (command == "help")
+                    out.append("init | destroy | create <definition> | clear | empty | depth | root | print\n"
+                               "value <key> | assign <key> <value> | parent <key> | child <key> left|right\n"
+                               "sibling <key> left|right | insert <key> left|right <definition>\n"
+                               "delete <key> left|right | traverse pre|in|post|level | quit\n"
+                               "keys containing blanks are written as (key), with \\) for ')'\n");
+                else
+                    fail(out, "unknown command");
+            }
+
+            auto lookup(std::string_view token)
+            {
+                auto key = detail::unescape(token, scratch_key);
+                if constexpr (std::is_same_v<key_type, std::string>)
+                    return key;
+                else
+                    return parse<key_type>(key);
+            }
+            template <typename T>
+            static T parse(std::string_view text)
+            {
+                T result;
+                if constexpr (std::is_same_v<T, std::string>)
+                    result.assign(text);
+                else
+                    element_parser<T>::parse(text, result);
+                return result;
+            }
+            auto find(std::string_view token)
+            {
+                return tree.try_get_iterator(lookup(token));
+            }
+            static bool is_left(std::string_view side)
+            {
+                return side != "right";
+            }
+
+            template <typename T>
+            std::string &append(std::string &out, T const &t)
+            {
+                detail::append_text(out, t, scratch_stream);
+                return out;
+            }
+            std::string &append_element(std::string &out, element_type const &element)
+            {
+                if constexpr (std::is_same_v<element_type, key_type>)
+                    return append(out, element);
+                else
+                    return append(append(out, get_key(element)).append(","), get_value(element));
+            }
+            template <typename iter>
+            void print_position(std::string &out, std::optional<iter> const &position)
+            {
+                if (!position)
+                    miss(out);
+                else if (!*position)
+                    out.append("null\n");
+                else
+                    append_element(out, **position).push_back('\n');
+            }
+            void miss(std::string &out)
+            {
+                fail(out, "no such key");
+            }
+            void fail(std::string &out, std::string_view message)
+            {
+                failed = true;
+                out.append("error: ").append(message).push_back('\n');
+            }
+
+            adapter_type tree;
+            std::string scratch_key, scratch_value;
+            std::ostringstream scratch_stream;
+            bool failed = false;
+        };
+    }
+}
+
+#endif //INC_201703_CONSOLE_UI_HPP
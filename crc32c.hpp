@@ -0,0 +1,92 @@
+#ifndef INC_201703_CRC32C_HPP
+#define INC_201703_CRC32C_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define DS_EXP_CRC32C_HARDWARE 1
+#include <nmmintrin.h>
+#endif
+
+namespace ds_exp
+{
+    inline namespace checksum
+    {
+        namespace detail
+        {
+            constexpr std::uint32_t crc32c_polynomial = 0x82f63b78u;
+
+            constexpr std::array<std::array<std::uint32_t, 256>, 8> make_crc32c_tables()
+            {
+                std::array<std::array<std::uint32_t, 256>, 8> tables{};
+                for (std::uint32_t i = 0; i < 256; ++i)
+                {
+                    auto crc = i;
+                    for (int bit = 0; bit < 8; ++bit)
+                        crc = crc & 1 ? (crc >> 1) ^ crc32c_polynomial : crc >> 1;
+                    tables[0][i] = crc;
+                }
+                for (std::size_t t = 1; t < 8; ++t)
+                    for (std::size_t i = 0; i < 256; ++i)
+                        tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xff];
+                return tables;
+            }
+            inline constexpr auto crc32c_tables = make_crc32c_tables();
+
+            inline std::uint32_t crc32c_software(std::uint32_t crc, unsigned char const *p, std::size_t size)
+            {
+                auto &t = crc32c_tables;
+                for (; size >= 8; p += 8, size -= 8)
+                {
+                    std::uint32_t low = crc ^ (std::uint32_t(p[0]) | std::uint32_t(p[1]) << 8 |
+                                               std::uint32_t(p[2]) << 16 | std::uint32_t(p[3]) << 24);
+                    crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+                          t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+                }
+                for (; size; ++p, --size)
+                    crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+                return crc;
+            }
+
+#ifdef DS_EXP_CRC32C_HARDWARE
+            __attribute__((target("sse4.2")))
+            inline std::uint32_t crc32c_hardware(std::uint32_t crc, unsigned char const *p, std::size_t size)
+            {
+                std::uint64_t wide = crc;
+                for (; size >= 8; p += 8, size -= 8)
+                {
+                    std::uint64_t word;
+                    std::memcpy(&word, p, sizeof word);
+                    wide = _mm_crc32_u64(wide, word);
+                }
+                crc = static_cast<std::uint32_t>(wide);
+                for (; size; ++p, --size)
+                    crc = _mm_crc32_u8(crc, *p);
+                return crc;
+            }
+            inline bool crc32c_hardware_available()
+            {
+                static bool const available = __builtin_cpu_supports("sse4.2");
+                return available;
+            }
+#endif
+        }
+
+        inline std::uint32_t crc32c(std::string_view data, std::uint32_t crc = 0)
+        {
+            auto p = reinterpret_cast<unsigned char const *>(data.data());
+            crc = ~crc;
+#ifdef DS_EXP_CRC32C_HARDWARE
+            if (detail::crc32c_hardware_available())
+                return ~detail::crc32c_hardware(crc, p, data.size());
+#endif
+            return ~detail::crc32c_software(crc, p, data.size());
+        }
+    }
+}
+
+#endif //INC_201703_CRC32C_HPP
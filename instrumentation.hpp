@@ -0,0 +1,282 @@
+#ifndef INC_201703_INSTRUMENTATION_HPP
+#define INC_201703_INSTRUMENTATION_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace ds_exp
+{
+    inline namespace instrument
+    {
+        enum class operation : unsigned
+        {
+            CreateBiTree, Value, Assign, Parent, Child, Sibling, InsertChild, DeleteChild, Traverse,
+            LevelOrderTraverse, count
+        };
+        constexpr std::size_t operation_count = static_cast<std::size_t>(operation::count);
+        constexpr std::size_t latency_buckets = 32;
+
+        inline char const *operation_name(operation op)
+        {
+            constexpr char const *names[] = {"CreateBiTree", "Value", "Assign", "Parent", "Child", "Sibling",
+                                             "InsertChild", "DeleteChild", "Traverse", "LevelOrderTraverse"};
+            return names[static_cast<std::size_t>(op)];
+        }
+
+        struct operation_stats
+        {
+            std::uint64_t calls = 0;
+            std::uint64_t nodes_visited = 0;
+            std::uint64_t allocations = 0;
+            std::uint64_t total_nanoseconds = 0;
+            std::array<std::uint64_t, latency_buckets> latency{};
+        };
+        using stats_snapshot = std::array<operation_stats, operation_count>;
+
+        struct heap_stats
+        {
+            std::uint64_t allocations = 0;
+            std::uint64_t deallocations = 0;
+            std::uint64_t allocated_bytes = 0;
+            std::uint64_t freed_bytes = 0;
+            std::uint64_t live_bytes_at_reset = 0;
+            std::uint64_t live_bytes() const
+            {
+                return live_bytes_at_reset + allocated_bytes - freed_bytes;
+            }
+        };
+
+        namespace detail
+        {
+            struct counter
+            {
+                std::atomic<std::uint64_t> value{0};
+                void add(std::uint64_t n)
+                {
+                    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+                }
+                std::uint64_t get() const
+                {
+                    return value.load(std::memory_order_relaxed);
+                }
+            };
+            struct operation_counters
+            {
+                counter calls, nodes_visited, allocations, total_nanoseconds;
+                std::array<counter, latency_buckets> latency;
+            };
+            struct heap_counters
+            {
+                counter allocations, deallocations, allocated_bytes, freed_bytes;
+            };
+            struct thread_counters
+            {
+                std::array<operation_counters, operation_count> operations;
+                heap_counters heap;
+            };
+
+            class registry
+            {
+            public:
+                static registry &instance()
+                {
+                    static auto shared = new registry;
+                    return *shared;
+                }
+                std::shared_ptr<thread_counters> attach()
+                {
+                    auto counters = std::make_shared<thread_counters>();
+                    std::lock_guard lock(mutex);
+                    threads.push_back(counters);
+                    return counters;
+                }
+                stats_snapshot snapshot()
+                {
+                    stats_snapshot result;
+                    std::lock_guard lock(mutex);
+                    for (auto &thread : threads)
+                        for (std::size_t op = 0; op < operation_count; ++op)
+                        {
+                            auto &source = thread->operations[op];
+                            auto &target = result[op];
+                            target.calls += source.calls.get();
+                            target.nodes_visited += source.nodes_visited.get();
+                            target.allocations += source.allocations.get();
+                            target.total_nanoseconds += source.total_nanoseconds.get();
+                            for (std::size_t bucket = 0; bucket < latency_buckets; ++bucket)
+                                target.latency[bucket] += source.latency[bucket].get();
+                        }
+                    return result;
+                }
+                heap_stats heap_snapshot()
+                {
+                    heap_stats result;
+                    std::lock_guard lock(mutex);
+                    result.live_bytes_at_reset = live_bytes_at_reset;
+                    for (auto &thread : threads)
+                    {
+                        result.allocations += thread->heap.allocations.get();
+                        result.deallocations += thread->heap.deallocations.get();
+                        result.allocated_bytes += thread->heap.allocated_bytes.get();
+                        result.freed_bytes += thread->heap.freed_bytes.get();
+                    }
+                    return result;
+                }
+                void reset()
+                {
+                    std::lock_guard lock(mutex);
+                    for (auto &thread : threads)
+                        for (auto &source : thread->operations)
+                        {
+                            source.calls.value = 0;
+                            source.nodes_visited.value = 0;
+                            source.allocations.value = 0;
+                            source.total_nanoseconds.value = 0;
+                            for (auto &bucket : source.latency)
+                                bucket.value = 0;
+                        }
+                    for (auto &thread : threads)
+                    {
+                        auto &heap = thread->heap;
+                        live_bytes_at_reset += heap.allocated_bytes.value.exchange(0) - heap.freed_bytes.value.exchange(0);
+                        heap.allocations.value = 0;
+                        heap.deallocations.value = 0;
+                    }
+                }
+
+            private:
+                std::mutex mutex;
+                std::vector<std::shared_ptr<thread_counters>> threads;
+                std::uint64_t live_bytes_at_reset = 0;
+            };
+
+            inline thread_counters &local_counters()
+            {
+                thread_local auto counters = registry::instance().attach().get();
+                return *counters;
+            }
+            inline operation_counters *&current_operation()
+            {
+                thread_local operation_counters *current = nullptr;
+                return current;
+            }
+        }
+
+        class scoped_operation
+        {
+        public:
+            explicit scoped_operation(operation op)
+                : counters(detail::local_counters().operations[static_cast<std::size_t>(op)]),
+                  outer(std::exchange(detail::current_operation(), &counters)),
+                  start(std::chrono::steady_clock::now())
+            {
+            }
+            scoped_operation(scoped_operation const &) = delete;
+            scoped_operation &operator=(scoped_operation const &) = delete;
+            ~scoped_operation()
+            {
+                auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                auto nanoseconds = static_cast<std::uint64_t>(elapsed > 0 ? elapsed : 0);
+                std::size_t bucket = 0;
+                while (bucket + 1 < latency_buckets && (nanoseconds >> (bucket + 1)) != 0)
+                    ++bucket;
+                counters.calls.add(1);
+                counters.total_nanoseconds.add(nanoseconds);
+                counters.latency[bucket].add(1);
+                detail::current_operation() = outer;
+            }
+
+        private:
+            detail::operation_counters &counters;
+            detail::operation_counters *outer;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        inline void record_visit()
+        {
+            if (auto current = detail::current_operation())
+                current->nodes_visited.add(1);
+        }
+        inline void record_allocation(std::size_t bytes)
+        {
+            auto &heap = detail::local_counters().heap;
+            heap.allocations.add(1);
+            heap.allocated_bytes.add(bytes);
+            if (auto current = detail::current_operation())
+                current->allocations.add(1);
+        }
+        inline void record_deallocation(std::size_t bytes)
+        {
+            auto &heap = detail::local_counters().heap;
+            heap.deallocations.add(1);
+            heap.freed_bytes.add(bytes);
+        }
+        inline stats_snapshot snapshot()
+        {
+            return detail::registry::instance().snapshot();
+        }
+        inline heap_stats heap_snapshot()
+        {
+            return detail::registry::instance().heap_snapshot();
+        }
+        inline void reset_statistics()
+        {
+            detail::registry::instance().reset();
+        }
+
+        inline std::ostream &dump_text(std::ostream &out, stats_snapshot const &stats = snapshot())
+        {
+            for (std::size_t op = 0; op < operation_count; ++op)
+            {
+                auto &s = stats[op];
+                if (!s.calls)
+                    continue;
+                out << operation_name(static_cast<operation>(op)) << ": calls " << s.calls << ", nodes visited "
+                    << s.nodes_visited << ", allocations " << s.allocations << ", mean "
+                    << s.total_nanoseconds / s.calls << "ns, latency";
+                for (std::size_t bucket = 0; bucket < latency_buckets; ++bucket)
+                    if (s.latency[bucket])
+                        out << " <" << (std::uint64_t(2) << bucket) << "ns:" << s.latency[bucket];
+                out << "\n";
+            }
+            return out;
+        }
+        inline std::ostream &dump_json(std::ostream &out, stats_snapshot const &stats = snapshot())
+        {
+            out << "{";
+            for (std::size_t op = 0; op < operation_count; ++op)
+            {
+                auto &s = stats[op];
+                out << (op ? "," : "") << "\"" << operation_name(static_cast<operation>(op)) << "\":{\"calls\":"
+                    << s.calls << ",\"nodes_visited\":" << s.nodes_visited << ",\"allocations\":" << s.allocations
+                    << ",\"total_ns\":" << s.total_nanoseconds << ",\"latency_log2_ns\":[";
+                for (std::size_t bucket = 0; bucket < latency_buckets; ++bucket)
+                    out << (bucket ? "," : "") << s.latency[bucket];
+                out << "]}";
+            }
+            return out << "}";
+        }
+    }
+}
+
+#ifdef DS_EXP_INSTRUMENT
+#define DS_EXP_TRACE_OPERATION(op) ::ds_exp::instrument::scoped_operation ds_exp_traced_operation_(::ds_exp::instrument::operation::op)
+#define DS_EXP_TRACE_VISIT() ::ds_exp::instrument::record_visit()
+#define DS_EXP_TRACE_ALLOCATION(bytes) ::ds_exp::instrument::record_allocation(bytes)
+#define DS_EXP_TRACE_DEALLOCATION(bytes) ::ds_exp::instrument::record_deallocation(bytes)
+#else
+#define DS_EXP_TRACE_OPERATION(op) static_cast<void>(0)
+#define DS_EXP_TRACE_VISIT() static_cast<void>(0)
+#define DS_EXP_TRACE_ALLOCATION(bytes) static_cast<void>(0)
+#define DS_EXP_TRACE_DEALLOCATION(bytes) static_cast<void>(0)
+#endif
+
+#endif //INC_201703_INSTRUMENTATION_HPP
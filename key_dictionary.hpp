@@ -0,0 +1,305 @@
+#ifndef INC_201703_KEY_DICTIONARY_HPP
+#define INC_201703_KEY_DICTIONARY_HPP
+
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "tree_parse.hpp"
+#include "save_load.hpp"
+
+namespace ds_exp
+{
+    inline namespace adapter
+    {
+        using namespace std::literals;
+
+        struct unknown_key_id : std::out_of_range
+        {
+            explicit unknown_key_id(std::uint32_t id)
+                : out_of_range("The key id "s + std::to_string(id) + " is not in the dictionary.")
+            {
+            }
+        };
+
+        template <typename Key>
+        class key_dictionary
+        {
+        public:
+            using key_type = Key;
+            using id_type = std::uint32_t;
+            using lookup_type = std::conditional_t<std::is_convertible_v<key_type const &, std::string_view>,
+                                                   std::string_view, key_type>;
+
+            key_dictionary()
+            {
+                intern(key_type{});
+            }
+
+            id_type intern(key_type const &key)
+            {
+                {
+                    std::shared_lock lock(mutex);
+                    if (auto found = ids.find(lookup_type(key)); found != ids.end())
+                        return found->second;
+                }
+                std::unique_lock lock(mutex);
+                if (auto found = ids.find(lookup_type(key)); found != ids.end())
+                    return found->second;
+                auto id = static_cast<id_type>(keys.size());
+                ids.emplace(lookup_type(keys.emplace_back(key)), id);
+                return id;
+            }
+            template <typename U>
+            bool find(U const &key, id_type &id) const
+            {
+                if constexpr (std::is_constructible_v<lookup_type, U const &>)
+                {
+                    std::shared_lock lock(mutex);
+                    auto found = ids.find(lookup_type(key));
+                    if (found == ids.end())
+                        return false;
+                    id = found->second;
+                    return true;
+                } else
+                    return find(key_type(key), id);
+            }
+            key_type const &get(id_type id) const
+            {
+                std::shared_lock lock(mutex);
+                if (id >= keys.size())
+                    throw unknown_key_id(id);
+                return keys[id];
+            }
+            std::size_t size() const
+            {
+                std::shared_lock lock(mutex);
+                return keys.size();
+            }
+            class import_mapping
+            {
+            public:
+                id_type translate(id_type saved) const
+                {
+                    if (saved >= ids.size())
+                        throw unknown_key_id(saved);
+                    return ids[saved];
+                }
+
+                friend std::istream &operator>>(std::istream &in, import_mapping const &keys)
+                {
+                    in.pword(keys.slot) = const_cast<import_mapping *>(&keys);
+                    return in;
+                }
+
+            private:
+                friend class key_dictionary;
+
+                import_mapping(int slot, std::vector<id_type> ids)
+                    : slot(slot), ids(std::move(ids))
+                {
+                }
+
+                int slot;
+                std::vector<id_type> ids;
+            };
+
+            id_type translate(id_type saved) const
+            {
+                std::shared_lock lock(mutex);
+                if (saved >= keys.size())
+                    throw unknown_key_id(saved);
+                return saved;
+            }
+            id_type translate(id_type saved, std::ios_base &source) const
+            {
+                if (auto mapping = static_cast<import_mapping const *>(source.pword(import_slot)))
+                    return mapping->translate(saved);
+                return translate(saved);
+            }
+
+            void save(std::ostream &out) const
+            {
+                std::shared_lock lock(mutex);
+                out << keys.size();
+                for (auto const &key : keys)
+                    escape(out << " (", key, ')') << ")";
+                out << " ";
+            }
+            import_mapping load(std::istream &in)
+            {
+                using ds_exp::assign_element;
+                std::size_t count = 0;
+                in >> count;
+                std::vector<id_type> mapping;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    parse::detail::force_read_char(in, '(');
+                    auto input = parse::detail::read_until(in, false, ')');
+                    parse::detail::force_read_char(in, ')');
+                    key_type key;
+                    assign_element(std::move(input), key);
+                    mapping.push_back(intern(key));
+                }
+                return import_mapping(import_slot, std::move(mapping));
+            }
+
+        private:
+            mutable std::shared_mutex mutex;
+            std::unordered_map<lookup_type, id_type> ids;
+            std::deque<key_type> keys;
+            int const import_slot = std::ios_base::xalloc();
+        };
+
+        namespace detail
+        {
+            inline int compact_keys_index()
+            {
+                static int index = std::ios_base::xalloc();
+                return index;
+            }
+        }
+        inline std::ostream &compact_keys(std::ostream &out)
+        {
+            out.iword(detail::compact_keys_index()) = 1;
+            return out;
+        }
+        inline std::ostream &full_keys(std::ostream &out)
+        {
+            out.iword(detail::compact_keys_index()) = 0;
+            return out;
+        }
+
+        template <typename Key, typename Tag = void>
+        class interned
+        {
+        public:
+            using key_type = Key;
+            using dictionary_type = key_dictionary<Key>;
+            using id_type = typename dictionary_type::id_type;
+
+            static dictionary_type &dictionary()
+            {
+                static dictionary_type shared;
+                return shared;
+            }
+            static interned from_id(id_type id)
+            {
+                interned result;
+                dictionary().get(id);
+                result.id_ = id;
+                return result;
+            }
+            template <typename U>
+            static std::optional<interned> resolve(U const &key)
+            {
+                interned result;
+                if (!dictionary().find(key, result.id_))
+                    return std::nullopt;
+                return result;
+            }
+
+            interned() = default;
+            template <typename U, std::enable_if_t<std::is_constructible_v<key_type, U &&> &&
+                                                   !std::is_same_v<std::decay_t<U>, interned>, int> = 0>
+            explicit interned(U &&key)
+                : id_(dictionary().intern(key_type(std::forward<U>(key))))
+            {
+            }
+
+            id_type id() const
+            {
+                return id_;
+            }
+            key_type const &get() const
+            {
+                return dictionary().get(id_);
+            }
+
+            friend bool operator==(interned const &lhs, interned const &rhs)
+            {
+                return lhs.id_ == rhs.id_;
+            }
+            friend bool operator!=(interned const &lhs, interned const &rhs)
+            {
+                return lhs.id_ != rhs.id_;
+            }
+            template <typename U, std::enable_if_t<std::is_constructible_v<key_type, U const &> &&
+                                                   !std::is_same_v<U, interned>, int> = 0>
+            friend bool operator==(interned const &lhs, U const &rhs)
+            {
+                auto resolved = resolve(rhs);
+                return resolved && *resolved == lhs;
+            }
+            template <typename U, std::enable_if_t<std::is_constructible_v<key_type, U const &> &&
+                                                   !std::is_same_v<U, interned>, int> = 0>
+            friend bool operator!=(interned const &lhs, U const &rhs)
+            {
+                return !(lhs == rhs);
+            }
+            friend bool operator<(interned const &lhs, interned const &rhs)
+            {
+                return lhs.id_ != rhs.id_ && lhs.get() < rhs.get();
+            }
+            friend std::ostream &operator<<(std::ostream &out, interned const &key)
+            {
+                if (out.iword(detail::compact_keys_index()))
+                    return out << '#' << key.id_;
+                std::ostringstream stream;
+                stream << key.get();
+                auto output = stream.str();
+                if (!output.empty() && (output.front() == '#' || output.front() == '\\'))
+                    out << '\\';
+                return out << output;
+            }
+
+        private:
+            id_type id_ = 0;
+        };
+
+        namespace detail
+        {
+            template <typename Key, typename Tag, typename ...Source>
+            bool assign_key_id(std::string const &str, interned<Key, Tag> &v, Source &...source)
+            {
+                using ds_exp::assign_element;
+                if (str.empty() || str.front() != '#')
+                    return false;
+                std::uint32_t id = 0;
+                assign_element(str.substr(1), id);
+                v = interned<Key, Tag>::from_id(interned<Key, Tag>::dictionary().translate(id, source...));
+                return true;
+            }
+        }
+
+        template <typename Key, typename Tag>
+        void assign_element(std::string str, interned<Key, Tag> &v)
+        {
+            using ds_exp::assign_element;
+            if (detail::assign_key_id(str, v))
+                return;
+            if (!str.empty() && str.front() == '\\')
+                str.erase(str.begin());
+            Key key;
+            assign_element(std::move(str), key);
+            v = interned<Key, Tag>(std::move(key));
+        }
+        template <typename Key, typename Tag>
+        void assign_element(std::string str, interned<Key, Tag> &v, std::ios_base &source)
+        {
+            if (!detail::assign_key_id(str, v, source))
+                assign_element(std::move(str), v);
+        }
+    }
+}
+
+#endif //INC_201703_KEY_DICTIONARY_HPP
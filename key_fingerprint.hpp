@@ -0,0 +1,207 @@
+#ifndef INC_201703_KEY_FINGERPRINT_HPP
+#define INC_201703_KEY_FINGERPRINT_HPP
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "binary_tree.hpp"
+#include "tree_export.hpp"
+#include "instrumentation.hpp"
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace ds_exp
+{
+    inline namespace adapter
+    {
+        namespace detail
+        {
+            template <typename Key>
+            constexpr bool fingerprintable = std::is_convertible_v<Key const &, std::string_view> ||
+                                             std::is_default_constructible_v<std::hash<Key>>;
+
+            template <typename Key>
+            std::uint32_t key_fingerprint(Key const &key)
+            {
+                std::uint64_t hash;
+                if constexpr (std::is_convertible_v<Key const &, std::string_view>)
+                    hash = std::hash<std::string_view>{}(key);
+                else
+                    hash = std::hash<Key>{}(key);
+                return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+            }
+
+            inline std::size_t scan_fingerprints_portable(std::uint32_t const *data, std::size_t pos, std::size_t size,
+                                                          std::uint32_t fingerprint)
+            {
+                for (; pos < size; ++pos)
+                    if (data[pos] == fingerprint)
+                        return pos;
+                return size;
+            }
+
+            inline std::size_t scan_fingerprints(std::uint32_t const *data, std::size_t pos, std::size_t size,
+                                                 std::uint32_t fingerprint)
+            {
+#if defined(__AVX2__)
+                auto needle = _mm256_set1_epi32(static_cast<int>(fingerprint));
+                for (; pos + 8 <= size; pos += 8)
+                {
+                    auto lanes = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data + pos));
+                    if (auto mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(lanes, needle))))
+                        for (;; ++pos, mask >>= 1)
+                            if (mask & 1)
+                                return pos;
+                }
+#elif defined(__SSE2__) || defined(_M_X64)
+                auto needle = _mm_set1_epi32(static_cast<int>(fingerprint));
+                for (; pos + 4 <= size; pos += 4)
+                {
+                    auto lanes = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + pos));
+                    if (auto mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lanes, needle))))
+                        for (;; ++pos, mask >>= 1)
+                            if (mask & 1)
+                                return pos;
+                }
+#endif
+                return scan_fingerprints_portable(data, pos, size, fingerprint);
+            }
+        }
+
+        template <typename T>
+        class fingerprint_table
+        {
+        public:
+            using node_type = node<T>;
+
+            template <typename KeyOf, typename order_t, typename dir_t>
+            void build(binary_tree<T> const &tree, KeyOf key_of, order_t order, dir_t dir)
+            {
+                nodes = export_nodes(tree, order, dir);
+                fingerprints.clear();
+                fingerprints.reserve(nodes.size());
+                for (auto p : nodes)
+                    fingerprints.push_back(detail::key_fingerprint(key_of(p->value)));
+                source = &tree;
+                built_at = tree.modification_count();
+            }
+            void clear()
+            {
+                nodes.clear(), fingerprints.clear();
+                source = nullptr;
+            }
+            bool stale(binary_tree<T> const &tree) const
+            {
+                return source != &tree || built_at != tree.modification_count();
+            }
+
+            template <typename Match>
+            node_type const *find(std::uint32_t fingerprint, Match match) const
+            {
+                for (std::size_t pos = 0;; ++pos)
+                {
+                    pos = detail::scan_fingerprints(fingerprints.data(), pos, fingerprints.size(), fingerprint);
+                    if (pos == fingerprints.size())
+                        return nullptr;
+                    DS_EXP_TRACE_VISIT();
+                    if (match(nodes[pos]->value))
+                        return nodes[pos];
+                }
+            }
+            std::size_t size() const
+            {
+                return nodes.size();
+            }
+            std::size_t heap_bytes() const
+            {
+                return nodes.capacity() * sizeof(node_type const *) + fingerprints.capacity() * sizeof(std::uint32_t);
+            }
+
+        private:
+            std::vector<node_type const *> nodes;
+            std::vector<std::uint32_t> fingerprints;
+            binary_tree<T> const *source = nullptr;
+            std::size_t built_at = 0;
+        };
+
+        template <typename T>
+        class fingerprint_cache
+        {
+        public:
+            using node_type = node<T>;
+
+            fingerprint_cache() = default;
+            fingerprint_cache(fingerprint_cache const &)
+            {
+            }
+            fingerprint_cache &operator=(fingerprint_cache const &)
+            {
+                clear();
+                return *this;
+            }
+            fingerprint_cache(fingerprint_cache &&src) noexcept
+            {
+                src.clear();
+            }
+            fingerprint_cache &operator=(fingerprint_cache &&src) noexcept
+            {
+                clear();
+                src.clear();
+                return *this;
+            }
+
+            template <typename KeyOf, typename Match>
+            bool find(binary_tree<T> const &tree, std::uint32_t fingerprint, KeyOf key_of, Match match,
+                      node_type const *&found)
+            {
+                {
+                    std::shared_lock lock(mutex);
+                    if (!table.stale(tree))
+                    {
+                        found = table.find(fingerprint, match);
+                        return true;
+                    }
+                }
+                std::unique_lock lock(mutex);
+                if (table.stale(tree))
+                {
+                    if (watched != &tree || watched_at != tree.modification_count())
+                        watched = &tree, watched_at = tree.modification_count(), lookups = 0;
+                    if (++lookups < build_after)
+                        return false;
+                    table.build(tree, key_of, preorder, left_first);
+                }
+                found = table.find(fingerprint, match);
+                return true;
+            }
+            void clear()
+            {
+                std::unique_lock lock(mutex);
+                table.clear();
+                watched = nullptr;
+                lookups = 0;
+            }
+            std::size_t heap_bytes() const
+            {
+                std::shared_lock lock(mutex);
+                return table.heap_bytes();
+            }
+
+        private:
+            static constexpr std::size_t build_after = 4;
+
+            mutable std::shared_mutex mutex;
+            fingerprint_table<T> table;
+            binary_tree<T> const *watched = nullptr;
+            std::size_t watched_at = 0, lookups = 0;
+        };
+    }
+}
+
+#endif //INC_201703_KEY_FINGERPRINT_HPP
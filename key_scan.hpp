@@ -0,0 +1,56 @@
+#ifndef INC_201703_KEY_SCAN_HPP
+#define INC_201703_KEY_SCAN_HPP
+
+#include "tree_adapter.hpp"
+#include "key_fingerprint.hpp"
+#include "resumable_traversal.hpp"
+
+namespace ds_exp
+{
+    inline namespace adapter
+    {
+        template <typename T>
+        class key_scan
+        {
+        public:
+            using node_type = node<T>;
+
+            template <typename order_t = preorder_t, typename dir_t = left_first_t>
+            explicit key_scan(binary_tree<T> const &tree, order_t order = order_t{}, dir_t dir = dir_t{})
+                : source(&tree)
+            {
+                table.build(tree, [](T const &element) -> decltype(auto)
+                {
+                    return get_key(element);
+                }, order, dir);
+            }
+
+            bool stale() const
+            {
+                return table.stale(*source);
+            }
+            template <typename Key>
+            T const *find(Key const &key) const
+            {
+                if (stale())
+                    throw traversal_invalidated();
+                auto &&lookup = lookup_key(key);
+                auto found = table.find(detail::key_fingerprint(lookup), [&](T const &element)
+                {
+                    return get_key(element) == lookup;
+                });
+                return found ? &found->value : nullptr;
+            }
+            std::size_t size() const
+            {
+                return table.size();
+            }
+
+        private:
+            binary_tree<T> const *source;
+            fingerprint_table<T> table;
+        };
+    }
+}
+
+#endif //INC_201703_KEY_SCAN_HPP
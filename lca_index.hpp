@@ -0,0 +1,212 @@
+#ifndef INC_201703_LCA_INDEX_HPP
+#define INC_201703_LCA_INDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "binary_tree.hpp"
+
+namespace ds_exp
+{
+    inline namespace tree
+    {
+        struct node_not_indexed : std::logic_error
+        {
+            node_not_indexed()
+                : logic_error("The node does not belong to the indexed tree.")
+            {
+            }
+        };
+
+        template <typename T>
+        class lca_index
+        {
+        public:
+            using tree_type = binary_tree<T>;
+            using const_iterator = typename tree_type::template const_iterator<preorder_t, left_first_t>;
+
+            explicit lca_index(tree_type const &tree)
+                : tree(&tree)
+            {
+                build();
+            }
+
+            bool stale() const
+            {
+                return built_at != tree->modification_count();
+            }
+            void refresh()
+            {
+                if (stale())
+                    build();
+            }
+            std::size_t size()
+            {
+                refresh();
+                return nodes.size();
+            }
+
+            template <typename H>
+            const_iterator position(H const &node)
+            {
+                return nodes[id(node)];
+            }
+            template <typename H>
+            std::size_t depth(H const &node)
+            {
+                return depths[id(node)];
+            }
+            template <typename H1, typename H2>
+            bool is_ancestor(H1 const &ancestor, H2 const &node)
+            {
+                auto a = id(ancestor), n = id(node);
+                return a <= n && n < a + sizes[a];
+            }
+            template <typename H1, typename H2>
+            T const *lowest_common_ancestor(H1 const &lhs, H2 const &rhs)
+            {
+                return element(lca(id(lhs), id(rhs)));
+            }
+            template <typename H1, typename H2>
+            std::size_t distance(H1 const &lhs, H2 const &rhs)
+            {
+                auto a = id(lhs), b = id(rhs);
+                return depths[a] + depths[b] - 2 * depths[lca(a, b)];
+            }
+            template <typename H>
+            T const *ancestor(H const &node, std::size_t k)
+            {
+                auto n = id(node);
+                return k > depths[n] ? nullptr : element(climb(n, k));
+            }
+            template <typename H1, typename H2>
+            std::vector<T const *> path(H1 const &from, H2 const &to)
+            {
+                auto a = id(from), b = id(to), top = lca(a, b);
+                std::vector<T const *> result;
+                for (; a != top; a = parents[a])
+                    result.push_back(element(a));
+                result.push_back(element(top));
+                auto middle = result.size();
+                for (; b != top; b = parents[b])
+                    result.push_back(element(b));
+                std::reverse(result.begin() + static_cast<std::ptrdiff_t>(middle), result.end());
+                return result;
+            }
+
+        private:
+            using index_type = std::uint32_t;
+
+            void build()
+            {
+                nodes.clear(), parents.clear(), depths.clear(), sizes.clear(), ids.clear();
+                for (auto iter = tree->begin(preorder); iter; ++iter)
+                {
+                    auto self = static_cast<index_type>(nodes.size());
+                    ids.emplace(&*iter, self);
+                    nodes.push_back(iter);
+                    if (iter == tree->root())
+                    {
+                        parents.push_back(self);
+                        depths.push_back(0);
+                    } else
+                    {
+                        auto parent = ids.at(&*iter.parent());
+                        parents.push_back(parent);
+                        depths.push_back(depths[parent] + 1);
+                    }
+                }
+                sizes.assign(nodes.size(), 1);
+                for (auto n = nodes.size(); n-- > 1;)
+                    sizes[parents[n]] += sizes[n];
+
+                minimum.assign(1, std::vector<index_type>(nodes.size()));
+                for (std::size_t n = 0; n < nodes.size(); ++n)
+                    minimum[0][n] = static_cast<index_type>(n);
+                for (std::size_t level = 1; (std::size_t(1) << level) <= nodes.size(); ++level)
+                {
+                    auto &below = minimum[level - 1];
+                    std::vector<index_type> row(nodes.size() - (std::size_t(1) << level) + 1);
+                    for (std::size_t n = 0; n < row.size(); ++n)
+                        row[n] = shallower(below[n], below[n + (std::size_t(1) << (level - 1))]);
+                    minimum.push_back(std::move(row));
+                }
+
+                jumps.assign(1, parents);
+                for (std::size_t level = 1; (std::size_t(1) << level) < nodes.size(); ++level)
+                {
+                    auto &below = jumps[level - 1];
+                    std::vector<index_type> row(nodes.size());
+                    for (std::size_t n = 0; n < nodes.size(); ++n)
+                        row[n] = below[below[n]];
+                    jumps.push_back(std::move(row));
+                }
+                built_at = tree->modification_count();
+            }
+
+            template <typename H>
+            index_type id(H const &node)
+            {
+                refresh();
+                T const *address;
+                if constexpr (std::is_pointer_v<H>)
+                    address = node;
+                else
+                {
+                    if (!node)
+                        throw node_not_indexed();
+                    address = &*node;
+                }
+                auto found = ids.find(address);
+                if (found == ids.end())
+                    throw node_not_indexed();
+                return found->second;
+            }
+            T const *element(index_type n) const
+            {
+                return &*nodes[n];
+            }
+            index_type shallower(index_type a, index_type b) const
+            {
+                return depths[b] < depths[a] ? b : a;
+            }
+            index_type lca(index_type a, index_type b) const
+            {
+                if (a == b)
+                    return a;
+                if (a > b)
+                    std::swap(a, b);
+                std::size_t first = a + 1, count = b - a, level = 0;
+                while ((std::size_t(2) << level) <= count)
+                    ++level;
+                return parents[shallower(minimum[level][first], minimum[level][b + 1 - (std::size_t(1) << level)])];
+            }
+            index_type climb(index_type n, std::size_t k) const
+            {
+                for (std::size_t level = 0; k; ++level, k >>= 1)
+                    if (k & 1)
+                        n = jumps[level][n];
+                return n;
+            }
+
+            tree_type const *tree;
+            std::size_t built_at = 0;
+            std::vector<const_iterator> nodes;
+            std::vector<index_type> parents, depths, sizes;
+            std::vector<std::vector<index_type>> minimum, jumps;
+            std::unordered_map<void const *, index_type> ids;
+        };
+
+        template <typename T>
+        lca_index<T> make_lca_index(binary_tree<T> const &tree)
+        {
+            return lca_index<T>(tree);
+        }
+    }
+}
+
+#endif //INC_201703_LCA_INDEX_HPP
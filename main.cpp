@@ -1,17 +1,108 @@
 
 
+#include <fstream>
+#include <iostream>
 #include "test/test_binary_tree.hpp"
 #include "test/test_tree_parse.hpp"
 #include "test/test_tree_adapter.hpp"
+#include "test/test_tree_export.hpp"
+#include "test/test_console_ui.hpp"
 #include "console_ui.hpp"
+#include "workload.hpp"
 
-int main()
+int main(int argc, char *argv[])
 {
     std::cout<<std::boolalpha;
     test_binary_tree();
     test_tree_parse();
     test_tree_adapter();
+    test_tree_export();
+    test_console_ui();
+    auto usage = [&]
+    {
+        std::cerr << "usage: " << argv[0] << " [script | -]\n"
+                  << "       " << argv[0] << " --replay <trace> | --replay-pairs <trace>\n"
+                  << "       " << argv[0] << " --generate <uniform|zipf|insert-heavy|deep-chain> <operations> <keys> <trace>"
+                  << std::endl;
+        return 2;
+    };
+    if (argc > 1 && (argv[1] == std::string("--replay") || argv[1] == std::string("--replay-pairs")))
+    {
+        if (argc != 3)
+            return usage();
+        std::ifstream trace(argv[2], std::ios::binary);
+        if (!trace.is_open())
+        {
+            std::cerr << "cannot open trace " << argv[2] << std::endl;
+            return usage();
+        }
+        try
+        {
+            ds_exp::tree_adapter<std::string> keys;
+            ds_exp::tree_adapter<std::string, std::string> pairs;
+            auto report = argv[1] == std::string("--replay") ? ds_exp::replay_trace(trace, keys)
+                                                             : ds_exp::replay_trace(trace, pairs);
+            std::cout << report;
+            return report.failures ? 1 : 0;
+        }
+        catch (std::exception const &e)
+        {
+            std::cerr << e.what() << std::endl;
+            return usage();
+        }
+    }
+    if (argc > 1 && argv[1] == std::string("--generate"))
+    {
+        if (argc != 6)
+            return usage();
+        std::string shape = argv[2];
+        if (shape != "uniform" && shape != "zipf" && shape != "insert-heavy" && shape != "deep-chain")
+        {
+            std::cerr << "unknown workload shape " << shape << std::endl;
+            return usage();
+        }
+        std::size_t operations = 0, keys = 0;
+        try
+        {
+            if (argv[3][0] == '-' || argv[4][0] == '-')
+                throw std::invalid_argument("negative count");
+            operations = std::stoul(argv[3]), keys = std::stoul(argv[4]);
+        }
+        catch (std::exception const &)
+        {
+            std::cerr << "operations and keys must be non-negative integers" << std::endl;
+            return usage();
+        }
+        std::ofstream trace(argv[5], std::ios::binary);
+        if (!trace.is_open())
+        {
+            std::cerr << "cannot create trace " << argv[5] << std::endl;
+            return usage();
+        }
+        ds_exp::generate_trace(trace, shape == "zipf" ? ds_exp::workload_shape::zipf
+                                      : shape == "insert-heavy" ? ds_exp::workload_shape::insert_heavy
+                                      : shape == "deep-chain" ? ds_exp::workload_shape::deep_chain
+                                      : ds_exp::workload_shape::uniform,
+                               operations, keys);
+        return trace ? 0 : 1;
+    }
     ds_exp::console_ui<std::string, std::string> ui;
+    if (argc > 1)
+    {
+        std::ifstream file;
+        if (argv[1] != std::string("-"))
+        {
+            file.open(argv[1], std::ios::binary);
+            if (!file.is_open())
+            {
+                std::cerr << "cannot open script " << argv[1] << std::endl;
+                return usage();
+            }
+        }
+        auto report = ui.execute_batch(argv[1] == std::string("-") ? std::cin : file, std::cout);
+        std::cerr << report << std::endl;
+        return report.failures ? 1 : 0;
+    }
     ui.execute();
     return 0;
 }
\ No newline at end of file
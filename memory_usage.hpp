@@ -0,0 +1,88 @@
+#ifndef INC_201703_MEMORY_USAGE_HPP
+#define INC_201703_MEMORY_USAGE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include "binary_tree.hpp"
+
+namespace ds_exp
+{
+    inline namespace tree
+    {
+        constexpr std::size_t estimated_allocation_overhead(std::size_t bytes)
+        {
+            constexpr std::size_t header = sizeof(std::size_t), alignment = 2 * sizeof(std::size_t), minimum = 4 * sizeof(std::size_t);
+            auto chunk = (bytes + header + alignment - 1) / alignment * alignment;
+            return (chunk < minimum ? minimum : chunk) - bytes;
+        }
+
+        struct memory_usage
+        {
+            std::size_t nodes = 0;
+            std::size_t value_bytes = 0;
+            std::size_t link_bytes = 0;
+            std::size_t value_heap_bytes = 0;
+            std::size_t index_bytes = 0;
+            std::size_t estimated_allocator_overhead = 0;
+            std::size_t container_bytes = 0;
+
+            void add_heap(std::size_t bytes)
+            {
+                value_heap_bytes += bytes;
+                estimated_allocator_overhead += estimated_allocation_overhead(bytes);
+            }
+            std::size_t node_bytes() const
+            {
+                return value_bytes + link_bytes;
+            }
+            std::size_t total() const
+            {
+                return node_bytes() + value_heap_bytes + index_bytes + estimated_allocator_overhead + container_bytes;
+            }
+            friend std::ostream &operator<<(std::ostream &out, memory_usage const &usage)
+            {
+                return out << "nodes " << usage.nodes << ", node bytes " << usage.node_bytes() << " (values "
+                           << usage.value_bytes << ", links " << usage.link_bytes << "), value heap bytes "
+                           << usage.value_heap_bytes << ", index bytes " << usage.index_bytes
+                           << ", estimated allocator overhead " << usage.estimated_allocator_overhead << ", total "
+                           << usage.total();
+            }
+        };
+
+        template <typename T>
+        void account_value(memory_usage &, T const &)
+        {
+        }
+        template <typename Char, typename Traits, typename Alloc>
+        void account_value(memory_usage &usage, std::basic_string<Char, Traits, Alloc> const &s)
+        {
+            auto object = reinterpret_cast<char const *>(&s), data = reinterpret_cast<char const *>(s.data());
+            std::less<char const *> less;
+            if (!less(data, object) && less(data, object + sizeof(s)))
+                return;
+            usage.add_heap((s.capacity() + 1) * sizeof(Char));
+        }
+
+        template <typename T>
+        memory_usage measure_memory(binary_tree<T> const &tree)
+        {
+            using node_type = typename binary_tree<T>::node_type;
+            memory_usage usage;
+            usage.container_bytes = sizeof(tree);
+            for (auto &value : tree_iterate(tree, preorder))
+            {
+                ++usage.nodes;
+                account_value(usage, value);
+            }
+            usage.value_bytes = usage.nodes * sizeof(T);
+            usage.link_bytes = usage.nodes * (sizeof(node_type) - sizeof(T));
+            usage.estimated_allocator_overhead += usage.nodes * estimated_allocation_overhead(sizeof(node_type));
+            return usage;
+        }
+    }
+}
+
+#endif //INC_201703_MEMORY_USAGE_HPP
@@ -0,0 +1,245 @@
+#ifndef INC_201703_OPERATION_TRACE_HPP
+#define INC_201703_OPERATION_TRACE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "instrumentation.hpp"
+
+namespace ds_exp
+{
+    inline namespace instrument
+    {
+        struct trace_corrupt : std::domain_error
+        {
+            explicit trace_corrupt(std::string const &what)
+                : domain_error("Corrupt operation trace: " + what + ".")
+            {
+            }
+        };
+
+        struct trace_record
+        {
+            operation op = operation::count;
+            std::uint64_t nanoseconds = 0;
+            std::vector<std::string> arguments;
+        };
+
+        namespace detail
+        {
+            constexpr char trace_magic[4] = {'D', 'S', 'T', 'R'};
+            constexpr std::uint64_t trace_max_arguments = 64;
+            constexpr std::uint64_t trace_max_argument_size = std::uint64_t(1) << 30;
+            constexpr std::size_t trace_read_chunk = 64 * 1024;
+
+            inline void put_varint(std::string &out, std::uint64_t value)
+            {
+                for (; value >= 0x80; value >>= 7)
+                    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+                out.push_back(static_cast<char>(value));
+            }
+            inline bool get_varint(std::istream &in, std::uint64_t &value)
+            {
+                value = 0;
+                for (unsigned shift = 0; shift < 64; shift += 7)
+                {
+                    auto byte = in.get();
+                    if (byte == std::istream::traits_type::eof())
+                        return false;
+                    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                    if (!(byte & 0x80))
+                        return true;
+                }
+                throw trace_corrupt("varint too long");
+            }
+            template <typename T, typename = void>
+            struct streamable : std::false_type
+            {
+            };
+            template <typename T>
+            struct streamable<T, std::void_t<decltype(std::declval<std::ostream &>() << std::declval<T const &>())>>
+                : std::true_type
+            {
+            };
+
+            template <typename T>
+            std::string format_argument(T const &t)
+            {
+                if constexpr (std::is_convertible_v<T const &, std::string_view>)
+                    return std::string(std::string_view(t));
+                else if constexpr (!streamable<T>::value)
+                    return {};
+                else
+                {
+                    std::ostringstream stream;
+                    stream << t;
+                    return stream.str();
+                }
+            }
+        }
+
+        class trace_writer
+        {
+        public:
+            explicit trace_writer(std::ostream &out)
+                : out(out)
+            {
+                out.write(detail::trace_magic, sizeof detail::trace_magic);
+            }
+            void write(trace_record const &record)
+            {
+                buffer.clear();
+                buffer.push_back(static_cast<char>(record.op));
+                detail::put_varint(buffer, record.nanoseconds - std::min(record.nanoseconds, last));
+                detail::put_varint(buffer, record.arguments.size());
+                for (auto &argument : record.arguments)
+                {
+                    detail::put_varint(buffer, argument.size());
+                    buffer.append(argument);
+                }
+                last = std::max(last, record.nanoseconds);
+                out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            }
+
+        private:
+            std::ostream &out;
+            std::string buffer;
+            std::uint64_t last = 0;
+        };
+
+        class trace_reader
+        {
+        public:
+            explicit trace_reader(std::istream &in)
+                : in(in)
+            {
+                char magic[sizeof detail::trace_magic];
+                if (!in.read(magic, sizeof magic) || std::memcmp(magic, detail::trace_magic, sizeof magic) != 0)
+                    throw trace_corrupt("bad magic");
+            }
+            bool next(trace_record &record)
+            {
+                auto op = in.get();
+                if (op == std::istream::traits_type::eof())
+                    return false;
+                if (static_cast<std::size_t>(op) >= operation_count)
+                    throw trace_corrupt("unknown operation");
+                std::uint64_t delta, count, size;
+                if (!detail::get_varint(in, delta) || !detail::get_varint(in, count))
+                    throw trace_corrupt("truncated record");
+                if (count > detail::trace_max_arguments)
+                    throw trace_corrupt("too many arguments");
+                record.op = static_cast<operation>(op);
+                record.nanoseconds = last += delta;
+                record.arguments.resize(static_cast<std::size_t>(count));
+                for (auto &argument : record.arguments)
+                {
+                    if (!detail::get_varint(in, size))
+                        throw trace_corrupt("truncated record");
+                    if (size > detail::trace_max_argument_size)
+                        throw trace_corrupt("argument too long");
+                    argument.clear();
+                    while (argument.size() < size)
+                    {
+                        auto offset = argument.size();
+                        auto chunk = std::min<std::size_t>(static_cast<std::size_t>(size) - offset, detail::trace_read_chunk);
+                        argument.resize(offset + chunk);
+                        if (!in.read(argument.data() + offset, static_cast<std::streamsize>(chunk)))
+                            throw trace_corrupt("truncated argument");
+                    }
+                }
+                return true;
+            }
+
+        private:
+            std::istream &in;
+            std::uint64_t last = 0;
+        };
+
+        class trace_recorder
+        {
+        public:
+            explicit trace_recorder(std::ostream &out)
+                : writer(out), start(std::chrono::steady_clock::now())
+            {
+            }
+            template <typename ...Args>
+            void record(operation op, Args const &...args)
+            {
+                trace_record record{op, 0, {detail::format_argument(args)...}};
+                std::lock_guard lock(mutex);
+                record.nanoseconds = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+                writer.write(record);
+                ++records;
+            }
+            std::size_t size() const
+            {
+                std::lock_guard lock(mutex);
+                return records;
+            }
+
+        private:
+            mutable std::mutex mutex;
+            trace_writer writer;
+            std::chrono::steady_clock::time_point start;
+            std::size_t records = 0;
+        };
+
+        namespace detail
+        {
+            inline trace_recorder *&current_recorder()
+            {
+                thread_local trace_recorder *current = nullptr;
+                return current;
+            }
+        }
+
+        inline trace_recorder *active_recorder()
+        {
+            return detail::current_recorder();
+        }
+
+        class scoped_recording
+        {
+        public:
+            explicit scoped_recording(trace_recorder &recorder)
+                : outer(std::exchange(detail::current_recorder(), &recorder))
+            {
+            }
+            scoped_recording(scoped_recording const &) = delete;
+            scoped_recording &operator=(scoped_recording const &) = delete;
+            ~scoped_recording()
+            {
+                detail::current_recorder() = outer;
+            }
+
+        private:
+            trace_recorder *outer;
+        };
+    }
+}
+
+#ifdef DS_EXP_RECORD
+#define DS_EXP_RECORD_CALL(op, ...) \
+    do \
+    { \
+        if (auto ds_exp_recorder_ = ::ds_exp::instrument::active_recorder()) \
+            ds_exp_recorder_->record(::ds_exp::instrument::operation::op, __VA_ARGS__); \
+    } while (false)
+#else
+#define DS_EXP_RECORD_CALL(op, ...) static_cast<void>(0)
+#endif
+
+#endif //INC_201703_OPERATION_TRACE_HPP
@@ -0,0 +1,272 @@
+#ifndef INC_201703_ORDERED_ADAPTER_HPP
+#define INC_201703_ORDERED_ADAPTER_HPP
+
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include "tree_adapter.hpp"
+
+namespace ds_exp
+{
+    inline namespace adapter
+    {
+        struct plain_access_t
+        {
+            constexpr plain_access_t() = default;
+        };
+        struct splay_access_t
+        {
+            constexpr splay_access_t() = default;
+        };
+        constexpr plain_access_t plain_access;
+        constexpr splay_access_t splay_access;
+
+        template <typename Key_t, typename Value_t = null_value_tag, typename access_t = plain_access_t>
+        class ordered_tree_adapter
+        {
+        public:
+            using element_type = typename value_traits<Key_t, Value_t>::type;
+            using tree_type = binary_tree<element_type>;
+            using key_type = typename value_traits<Key_t, Value_t>::key_type;
+            using value_type = typename value_traits<Key_t, Value_t>::value_type;
+            using iterator = decltype(std::declval<tree_type &>().root(inorder));
+            using const_iterator = decltype(std::declval<tree_type const &>().root(inorder));
+            using precondition_failed_to_satisfy = typename tree_adapter<Key_t, Value_t>::precondition_failed_to_satisfy;
+
+        private:
+            tree_type tree;
+            std::size_t size = 0;
+
+        public:
+            ordered_tree_adapter() = default;
+            template <typename Iter>
+            static ordered_tree_adapter from_sorted(Iter first, Iter last)
+            {
+                ordered_tree_adapter result;
+                result.tree = tree_type::from_sorted(first, last);
+                result.size = static_cast<std::size_t>(std::distance(first, last));
+                return result;
+            }
+
+            iterator Insert(key_type const &key)
+            {
+                return insert(key, [&]
+                {
+                    return make_element(key, value_type{});
+                }, [](element_type &)
+                {});
+            }
+            template <typename U>
+            iterator Insert(key_type const &key, U &&value)
+            {
+                static_assert(!std::is_same_v<element_type, key_type>, "a key-only tree has no value to insert");
+                return insert(key, [&]
+                {
+                    return make_element(key, std::forward<U>(value));
+                }, [&](element_type &element)
+                {
+                    get_value(element) = std::forward<U>(value);
+                });
+            }
+            template <typename K = key_type>
+            auto &Value(K const &key)
+            {
+                auto iter = get_iterator(key);
+                return get_value(*iter);
+            }
+            template <typename K = key_type>
+            auto &Value(K const &key) const
+            {
+                if (auto iter = lookup(tree, lookup_key(key)))
+                    return get_value(*iter);
+                throw precondition_failed_to_satisfy(__func__);
+            }
+            template <typename U, typename K = key_type>
+            void Assign(K const &key, U &&value)
+            {
+                get_value(*get_iterator(key)) = std::forward<U>(value);
+            }
+            template <typename K = key_type>
+            bool Contains(K const &key)
+            {
+                auto iter = lookup(tree, lookup_key(key));
+                if (iter)
+                    access(iter);
+                return static_cast<bool>(iter);
+            }
+            template <typename K = key_type>
+            iterator get_iterator(K const &key)
+            {
+                auto iter = lookup(tree, lookup_key(key));
+                if (!iter)
+                    throw precondition_failed_to_satisfy(__func__);
+                access(iter);
+                return iter;
+            }
+            template <typename K = key_type>
+            iterator LowerBound(K const &key)
+            {
+                return lower_bound(tree, lookup_key(key));
+            }
+            template <typename K = key_type>
+            const_iterator LowerBound(K const &key) const
+            {
+                return lower_bound(tree, lookup_key(key));
+            }
+            template <typename L = key_type, typename H = key_type>
+            auto Range(L const &lo, H const &hi)
+            {
+                return range(tree, lookup_key(lo), lookup_key(hi));
+            }
+            template <typename L = key_type, typename H = key_type>
+            auto Range(L const &lo, H const &hi) const
+            {
+                return range(tree, lookup_key(lo), lookup_key(hi));
+            }
+            template <typename K = key_type>
+            auto Prefix(K const &prefix)
+            {
+                return prefix_range(tree, lookup_key(prefix));
+            }
+            template <typename K = key_type>
+            auto Prefix(K const &prefix) const
+            {
+                return prefix_range(tree, lookup_key(prefix));
+            }
+
+            std::size_t Size() const
+            {
+                return size;
+            }
+            std::size_t Depth() const
+            {
+                return tree.depth();
+            }
+            auto Root() const
+            {
+                return tree.root(inorder);
+            }
+            auto begin()
+            {
+                return tree.begin(inorder);
+            }
+            auto end()
+            {
+                return tree.end(inorder);
+            }
+            auto begin() const
+            {
+                return tree.begin(inorder);
+            }
+            auto end() const
+            {
+                return tree.end(inorder);
+            }
+
+        private:
+            template <typename U>
+            static element_type make_element(key_type const &key, U &&value)
+            {
+                if constexpr (std::is_same_v<element_type, key_type>)
+                    return key;
+                else
+                    return element_type{key, std::forward<U>(value)};
+            }
+            template <typename Make, typename Update>
+            iterator insert(key_type const &key, Make make, Update update)
+            {
+                auto iter = tree.root(inorder);
+                if (!iter)
+                {
+                    tree.set_root(make());
+                    ++size;
+                    return tree.root(inorder);
+                }
+                while (true)
+                {
+                    bool less = key < *iter;
+                    if (!less && !(*iter < key))
+                    {
+                        update(*iter);
+                        break;
+                    }
+                    auto child = less ? iter.first_child(left_child) : iter.first_child(right_child);
+                    if (!child)
+                    {
+                        iter = less ? tree.new_child(iter, make(), left_child) : tree.new_child(iter, make(), right_child);
+                        ++size;
+                        break;
+                    }
+                    iter = child;
+                }
+                access(iter);
+                return iter;
+            }
+            template <typename Tree, typename K>
+            static auto lookup(Tree &tree, K const &key)
+            {
+                auto iter = tree.root(inorder);
+                while (iter)
+                {
+                    DS_EXP_TRACE_VISIT();
+                    if (key < *iter)
+                        iter = iter.first_child(left_child);
+                    else if (*iter < key)
+                        iter = iter.first_child(right_child);
+                    else
+                        break;
+                }
+                return iter;
+            }
+            template <typename Tree, typename K>
+            static auto lower_bound(Tree &tree, K const &key)
+            {
+                auto iter = tree.root(inorder), result = tree.end(inorder);
+                while (iter)
+                {
+                    DS_EXP_TRACE_VISIT();
+                    if (*iter < key)
+                        iter = iter.first_child(right_child);
+                    else
+                    {
+                        result = iter;
+                        iter = iter.first_child(left_child);
+                    }
+                }
+                return result;
+            }
+            template <typename Tree, typename L, typename H>
+            static auto range(Tree &tree, L const &lo, H const &hi)
+            {
+                auto first = lower_bound(tree, lo);
+                return iterator_range<decltype(first)>(first, lo < hi ? lower_bound(tree, hi) : first);
+            }
+            template <typename Tree, typename K>
+            static auto prefix_range(Tree &tree, K const &prefix)
+            {
+                using view_type = std::basic_string_view<typename key_type::value_type, typename key_type::traits_type>;
+                view_type prefix_view(prefix);
+                auto first = lower_bound(tree, prefix_view);
+                auto iter = tree.root(inorder), last = tree.end(inorder);
+                while (iter)
+                {
+                    DS_EXP_TRACE_VISIT();
+                    if (view_type(get_key(*iter)).substr(0, prefix_view.size()) > prefix_view)
+                    {
+                        last = iter;
+                        iter = iter.first_child(left_child);
+                    } else
+                        iter = iter.first_child(right_child);
+                }
+                return iterator_range<decltype(first)>(first, last);
+            }
+            void access(iterator iter)
+            {
+                if constexpr (std::is_same_v<access_t, splay_access_t>)
+                    tree.splay(iter);
+            }
+        };
+    }
+}
+
+#endif //INC_201703_ORDERED_ADAPTER_HPP
@@ -0,0 +1,38 @@
+#ifndef INC_201703_PARALLEL_HPP
+#define INC_201703_PARALLEL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ds_exp
+{
+    inline namespace parallel
+    {
+        inline unsigned default_concurrency()
+        {
+            auto threads = std::thread::hardware_concurrency();
+            return threads ? threads : 1;
+        }
+
+        template <typename Callable>
+        void parallel_for(std::size_t count, unsigned threads, Callable callable)
+        {
+            std::atomic<std::size_t> next{0};
+            auto worker = [&]
+            {
+                for (auto i = next++; i < count; i = next++)
+                    callable(i);
+            };
+            std::vector<std::thread> pool;
+            for (unsigned i = 1; i < threads && i < count; ++i)
+                pool.emplace_back(worker);
+            worker();
+            for (auto &thread : pool)
+                thread.join();
+        }
+    }
+}
+
+#endif //INC_201703_PARALLEL_HPP
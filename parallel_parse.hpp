@@ -0,0 +1,273 @@
+#ifndef INC_201703_PARALLEL_PARSE_HPP
+#define INC_201703_PARALLEL_PARSE_HPP
+
+#include <exception>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "binary_tree.hpp"
+#include "tree_parse.hpp"
+#include "parallel.hpp"
+
+namespace ds_exp
+{
+    inline namespace parse
+    {
+        namespace detail
+        {
+            struct token
+            {
+                enum kind_t : unsigned char
+                {
+                    null, quoted, bare
+                };
+                kind_t kind;
+                std::size_t begin;
+                std::size_t end;
+            };
+            struct lex_result
+            {
+                std::vector<token> tokens;
+                std::size_t start = std::string_view::npos;
+                std::size_t end = std::string_view::npos;
+                bool closed = false;
+                bool failed = false;
+            };
+
+            inline bool is_space(char c)
+            {
+                return std::isspace(static_cast<unsigned char>(c));
+            }
+            inline std::size_t skip_space(std::string_view text, std::size_t pos)
+            {
+                while (pos < text.size() && is_space(text[pos]))
+                    ++pos;
+                return pos;
+            }
+
+            inline lex_result lex_elements(std::string_view text, std::size_t pos, std::size_t limit, bool strict)
+            {
+                lex_result result;
+                result.start = pos;
+                auto fail = [&](auto error)
+                {
+                    if (strict)
+                        throw error;
+                    result.failed = true;
+                };
+                while (pos < limit)
+                {
+                    auto first = skip_space(text, pos), separator = first;
+                    if (first == text.size())
+                        return fail(unexpected_end()), result;
+                    if (text[first] == '(')
+                    {
+                        auto last = first + 1;
+                        while (last < text.size() && (text[last] != ')' || text[last - 1] == '\\'))
+                            ++last;
+                        if (last == text.size())
+                            return fail(unexpected_end()), result;
+                        result.tokens.push_back(token{token::quoted, first + 1, last});
+                        separator = last + 1;
+                    } else if (text.compare(first, 4, "null") == 0)
+                    {
+                        result.tokens.push_back(token{token::null, first, first + 4});
+                        separator = first + 4;
+                    } else
+                    {
+                        auto last = first;
+                        while (last < text.size() &&
+                               ((text[last] != ',' && text[last] != ']') || (last > first && text[last - 1] == '\\')))
+                            ++last;
+                        if (last == text.size())
+                            return fail(unexpected_end()), result;
+                        result.tokens.push_back(token{token::bare, first, last});
+                        separator = last;
+                    }
+                    separator = skip_space(text, separator);
+                    if (separator == text.size())
+                        return fail(unexpected_end()), result;
+                    if (text[separator] == ']')
+                    {
+                        result.closed = true;
+                        result.end = separator + 1;
+                        return result;
+                    }
+                    if (text[separator] != ',')
+                        return fail(expect_failed(",")), result;
+                    pos = separator + 1;
+                }
+                result.end = pos;
+                return result;
+            }
+
+            inline std::size_t speculative_start(std::string_view text, std::size_t pos)
+            {
+                for (; pos < text.size(); ++pos)
+                {
+                    if (text[pos] != ')' || text[pos - 1] == '\\')
+                        continue;
+                    auto separator = skip_space(text, pos + 1);
+                    if (separator < text.size() && text[separator] == ',')
+                        return separator + 1;
+                }
+                return std::string_view::npos;
+            }
+
+            inline std::string unescape_token(std::string_view text, token const &t)
+            {
+                std::string str;
+                str.reserve(t.end - t.begin);
+                for (auto pos = t.begin; pos < t.end; ++pos)
+                {
+                    if (text[pos] == '\\' && pos + 1 < t.end)
+                    {
+                        auto next = text[pos + 1];
+                        if (t.kind == token::quoted ? next == ')' : (next == ',' || next == ']'))
+                            ++pos;
+                    }
+                    str.push_back(text[pos]);
+                }
+                return str;
+            }
+        }
+
+        template <typename direction, typename T>
+        class parallel_tree_parse
+        {
+            using tree_type = binary_tree<T>;
+            using value_type = typename tree_type::value_type;
+            using token = detail::token;
+            std::string_view source;
+            unsigned threads;
+            std::size_t chunk_size;
+
+        public:
+            explicit parallel_tree_parse(std::string_view in, unsigned threads = default_concurrency(),
+                                         std::size_t chunk_size = std::size_t(1) << 20)
+                : source(in), threads(threads ? threads : 1), chunk_size(chunk_size ? chunk_size : 1)
+            {
+            }
+            std::optional<tree_type> get_binary_tree()
+            {
+                auto tokens = tokenize();
+                return assemble(convert(tokens));
+            }
+
+        private:
+            std::vector<token> tokenize() const
+            {
+                auto first = detail::skip_space(source, 0);
+                if (first == source.size() || source[first] != '[')
+                    throw expect_failed("[");
+                ++first;
+
+                auto count = (source.size() - first + chunk_size - 1) / chunk_size;
+                std::vector<std::size_t> starts(count);
+                std::vector<detail::lex_result> chunks(count);
+                parallel_for(count, threads, [&](std::size_t i)
+                {
+                    starts[i] = i == 0 ? first : detail::speculative_start(source, first + i * chunk_size);
+                });
+                parallel_for(count, threads, [&](std::size_t i)
+                {
+                    auto limit = std::string_view::npos;
+                    for (auto next = i + 1; next < count && limit == std::string_view::npos; ++next)
+                        if (starts[next] != std::string_view::npos && starts[next] > starts[i])
+                            limit = starts[next];
+                    if (starts[i] != std::string_view::npos)
+                        chunks[i] = detail::lex_elements(source, starts[i], limit, false);
+                });
+
+                std::vector<token> tokens;
+                auto pos = first;
+                std::size_t next = 0;
+                for (bool closed = false; !closed;)
+                {
+                    while (next < chunks.size() && (chunks[next].start < pos || chunks[next].start == std::string_view::npos))
+                        ++next;
+                    detail::lex_result lexed;
+                    if (next < chunks.size() && chunks[next].start == pos && !chunks[next].failed)
+                        lexed = std::move(chunks[next++]);
+                    else
+                    {
+                        auto limit = std::string_view::npos;
+                        for (auto later = next; later < chunks.size() && limit == std::string_view::npos; ++later)
+                            if (chunks[later].start != std::string_view::npos && chunks[later].start > pos)
+                                limit = chunks[later].start;
+                        lexed = detail::lex_elements(source, pos, limit, true);
+                    }
+                    tokens.insert(tokens.end(), lexed.tokens.begin(), lexed.tokens.end());
+                    pos = lexed.end;
+                    closed = lexed.closed;
+                }
+                return tokens;
+            }
+
+            std::vector<std::optional<value_type>> convert(std::vector<token> const &tokens) const
+            {
+                constexpr std::size_t block = 4096;
+                std::vector<std::optional<value_type>> values(tokens.size());
+                std::vector<std::exception_ptr> errors((tokens.size() + block - 1) / block);
+                parallel_for(errors.size(), threads, [&](std::size_t b)
+                {
+                    try
+                    {
+                        for (auto i = b * block; i < tokens.size() && i < (b + 1) * block; ++i)
+                        {
+                            if (tokens[i].kind == token::null)
+                                continue;
+                            value_type result;
+                            assign_element(detail::unescape_token(source, tokens[i]), result);
+                            values[i] = std::move(result);
+                        }
+                    }
+                    catch (...)
+                    {
+                        errors[b] = std::current_exception();
+                    }
+                });
+                for (auto &error : errors)
+                    if (error)
+                        std::rethrow_exception(error);
+                return values;
+            }
+
+            static std::optional<tree_type> assemble(std::vector<std::optional<value_type>> values)
+            {
+                using iterator = decltype(std::declval<tree_type &>().root());
+                if (!values.front())
+                {
+                    if (values.size() > 1)
+                        throw expect_failed("]");
+                    return std::nullopt;
+                }
+                tree_type tree;
+                tree.set_root(std::move(*values.front()));
+                std::vector<std::pair<iterator, bool>> stack;
+                stack.emplace_back(tree.root(), true);
+                for (std::size_t i = 1; i < values.size(); ++i)
+                {
+                    if (stack.empty())
+                        throw expect_failed("]");
+                    auto[parent, first] = stack.back();
+                    if (first)
+                        stack.back().second = false;
+                    else
+                        stack.pop_back();
+                    if (!values[i])
+                        continue;
+                    auto child = first ? tree.new_child(parent, std::move(*values[i]), direction{})
+                                       : tree.new_child(parent, std::move(*values[i]), typename direction::inverse{});
+                    stack.emplace_back(child, true);
+                }
+                if (!stack.empty())
+                    throw expect_failed(",");
+                return tree;
+            }
+        };
+    }
+}
+
+#endif //INC_201703_PARALLEL_PARSE_HPP
@@ -0,0 +1,329 @@
+#ifndef INC_201703_RANGE_ADAPTORS_HPP
+#define INC_201703_RANGE_ADAPTORS_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "binary_tree.hpp"
+
+namespace ds_exp
+{
+    inline namespace tree
+    {
+        namespace detail
+        {
+            template <typename Range>
+            using range_iterator_t = decltype(std::declval<Range &>().begin());
+
+            template <typename base_iterator, typename reference>
+            struct adapted_iterator_types
+            {
+                using difference_type = std::ptrdiff_t;
+                using value_type = std::remove_cv_t<std::remove_reference_t<reference>>;
+                using pointer = std::add_pointer_t<std::remove_reference_t<reference>>;
+                using iterator_category = std::conditional_t<std::is_reference_v<reference>,
+                    std::forward_iterator_tag, std::input_iterator_tag>;
+            };
+        }
+
+        template <typename Range, typename Pred>
+        class filter_range
+        {
+            using base_iterator = detail::range_iterator_t<Range>;
+            using base_reference = decltype(*std::declval<base_iterator &>());
+
+        public:
+            class iterator : public detail::adapted_iterator_types<base_iterator, base_reference>
+            {
+                friend class filter_range;
+
+                iterator(base_iterator current, base_iterator last, Pred *pred)
+                    : current(current), last(last), pred(pred)
+                {
+                    satisfy();
+                }
+                void satisfy()
+                {
+                    while (current != last && !(*pred)(*current))
+                        ++current;
+                }
+
+                base_iterator current{}, last{};
+                Pred *pred = nullptr;
+            public:
+                using reference = base_reference;
+
+                iterator() = default;
+                reference operator*() const
+                {
+                    return *current;
+                }
+                iterator &operator++()
+                {
+                    ++current;
+                    satisfy();
+                    return *this;
+                }
+                iterator operator++(int)
+                {
+                    auto iter = *this;
+                    return ++*this, iter;
+                }
+                friend bool operator==(iterator const &lhs, iterator const &rhs)
+                {
+                    return lhs.current == rhs.current;
+                }
+                friend bool operator!=(iterator const &lhs, iterator const &rhs)
+                {
+                    return !(lhs == rhs);
+                }
+            };
+
+            filter_range(Range &&base, Pred pred)
+                : base(std::forward<Range>(base)), pred(std::move(pred))
+            {
+            }
+            iterator begin()
+            {
+                return iterator(base.begin(), base.end(), &pred);
+            }
+            iterator end()
+            {
+                auto last = base.end();
+                return iterator(last, last, &pred);
+            }
+
+        private:
+            Range base;
+            Pred pred;
+        };
+
+        template <typename Range, typename Callable>
+        class transform_range
+        {
+            using base_iterator = detail::range_iterator_t<Range>;
+            using result_reference = decltype(std::declval<Callable &>()(*std::declval<base_iterator &>()));
+
+        public:
+            class iterator : public detail::adapted_iterator_types<base_iterator, result_reference>
+            {
+                friend class transform_range;
+
+                iterator(base_iterator current, Callable *callable)
+                    : current(current), callable(callable)
+                {
+                }
+
+                base_iterator current{};
+                Callable *callable = nullptr;
+            public:
+                using reference = result_reference;
+
+                iterator() = default;
+                reference operator*() const
+                {
+                    return (*callable)(*current);
+                }
+                iterator &operator++()
+                {
+                    return ++current, *this;
+                }
+                iterator operator++(int)
+                {
+                    auto iter = *this;
+                    return ++*this, iter;
+                }
+                friend bool operator==(iterator const &lhs, iterator const &rhs)
+                {
+                    return lhs.current == rhs.current;
+                }
+                friend bool operator!=(iterator const &lhs, iterator const &rhs)
+                {
+                    return !(lhs == rhs);
+                }
+            };
+
+            transform_range(Range &&base, Callable callable)
+                : base(std::forward<Range>(base)), callable(std::move(callable))
+            {
+            }
+            iterator begin()
+            {
+                return iterator(base.begin(), &callable);
+            }
+            iterator end()
+            {
+                return iterator(base.end(), &callable);
+            }
+
+        private:
+            Range base;
+            Callable callable;
+        };
+
+        template <typename Range, typename Pred>
+        class take_while_range
+        {
+            using base_iterator = detail::range_iterator_t<Range>;
+            using base_reference = decltype(*std::declval<base_iterator &>());
+
+        public:
+            class iterator : public detail::adapted_iterator_types<base_iterator, base_reference>
+            {
+                friend class take_while_range;
+
+                iterator(base_iterator current, base_iterator last, std::size_t remaining, Pred *pred)
+                    : current(current), last(last), remaining(remaining), pred(pred)
+                {
+                }
+                bool at_end() const
+                {
+                    return remaining == 0 || current == last || (pred && !(*pred)(*current));
+                }
+
+                base_iterator current{}, last{};
+                std::size_t remaining = 0;
+                Pred *pred = nullptr;
+            public:
+                using reference = base_reference;
+
+                iterator() = default;
+                reference operator*() const
+                {
+                    return *current;
+                }
+                iterator &operator++()
+                {
+                    if (--remaining != 0)
+                        ++current;
+                    return *this;
+                }
+                iterator operator++(int)
+                {
+                    auto iter = *this;
+                    return ++*this, iter;
+                }
+                friend bool operator==(iterator const &lhs, iterator const &rhs)
+                {
+                    auto lhs_end = lhs.at_end(), rhs_end = rhs.at_end();
+                    return lhs_end || rhs_end ? lhs_end == rhs_end : lhs.current == rhs.current;
+                }
+                friend bool operator!=(iterator const &lhs, iterator const &rhs)
+                {
+                    return !(lhs == rhs);
+                }
+            };
+
+            take_while_range(Range &&base, std::size_t count, std::optional<Pred> pred)
+                : base(std::forward<Range>(base)), count(count), pred(std::move(pred))
+            {
+            }
+            iterator begin()
+            {
+                return iterator(base.begin(), base.end(), count, pred ? &*pred : nullptr);
+            }
+            iterator end()
+            {
+                auto last = base.end();
+                return iterator(last, last, 0, nullptr);
+            }
+
+        private:
+            Range base;
+            std::size_t count;
+            std::optional<Pred> pred;
+        };
+
+        namespace detail
+        {
+            struct always_true
+            {
+                template <typename U>
+                bool operator()(U const &) const
+                {
+                    return true;
+                }
+            };
+
+            template <typename Pred>
+            struct filter_closure
+            {
+                Pred pred;
+                template <typename Range>
+                auto operator()(Range &&range) &&
+                {
+                    return filter_range<Range, Pred>(std::forward<Range>(range), std::move(pred));
+                }
+            };
+            template <typename Callable>
+            struct transform_closure
+            {
+                Callable callable;
+                template <typename Range>
+                auto operator()(Range &&range) &&
+                {
+                    return transform_range<Range, Callable>(std::forward<Range>(range), std::move(callable));
+                }
+            };
+            template <typename Pred>
+            struct take_while_closure
+            {
+                std::size_t count;
+                std::optional<Pred> pred;
+                template <typename Range>
+                auto operator()(Range &&range) &&
+                {
+                    return take_while_range<Range, Pred>(std::forward<Range>(range), count, std::move(pred));
+                }
+            };
+
+            template <typename>
+            struct is_range_closure : std::false_type
+            {
+            };
+            template <typename Pred>
+            struct is_range_closure<filter_closure<Pred>> : std::true_type
+            {
+            };
+            template <typename Callable>
+            struct is_range_closure<transform_closure<Callable>> : std::true_type
+            {
+            };
+            template <typename Pred>
+            struct is_range_closure<take_while_closure<Pred>> : std::true_type
+            {
+            };
+        }
+
+        template <typename Pred>
+        auto filter(Pred pred)
+        {
+            return detail::filter_closure<Pred>{std::move(pred)};
+        }
+        template <typename Callable>
+        auto transform(Callable callable)
+        {
+            return detail::transform_closure<Callable>{std::move(callable)};
+        }
+        inline auto take(std::size_t count)
+        {
+            return detail::take_while_closure<detail::always_true>{count, std::nullopt};
+        }
+        template <typename Pred>
+        auto take_while(Pred pred)
+        {
+            return detail::take_while_closure<Pred>{static_cast<std::size_t>(-1), std::move(pred)};
+        }
+
+        template <typename Range, typename Closure,
+            std::enable_if_t<detail::is_range_closure<std::decay_t<Closure>>::value, int> = 0>
+        auto operator|(Range &&range, Closure &&closure)
+        {
+            return std::decay_t<Closure>(std::forward<Closure>(closure))(std::forward<Range>(range));
+        }
+    }
+}
+
+#endif //INC_201703_RANGE_ADAPTORS_HPP
@@ -0,0 +1,103 @@
+#ifndef INC_201703_RESUMABLE_TRAVERSAL_HPP
+#define INC_201703_RESUMABLE_TRAVERSAL_HPP
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "binary_tree.hpp"
+
+namespace ds_exp
+{
+    inline namespace tree
+    {
+        struct traversal_invalidated : std::logic_error
+        {
+            traversal_invalidated()
+                : logic_error("The tree was restructured while a resumable traversal was suspended.")
+            {
+            }
+        };
+
+        template <typename tree_t, typename order_t, typename dir_t = left_first_t>
+        class resumable_traversal
+        {
+            using iterator = decltype(std::declval<tree_t &>().begin(order_t{}, dir_t{}));
+
+        public:
+            explicit resumable_traversal(tree_t &tree, order_t = order_t{}, dir_t = dir_t{})
+                : tree(&tree), current(tree.begin(order_t{}, dir_t{})), modifications(tree.modification_count())
+            {
+            }
+
+            template <typename Callable>
+            bool resume(Callable &&callable, std::size_t budget)
+            {
+                for (; budget != 0 && !done(); --budget)
+                    visit(callable);
+                return done();
+            }
+            template <typename Callable, typename Rep, typename Period>
+            bool resume_for(Callable &&callable, std::chrono::duration<Rep, Period> slice, std::size_t stride = 64)
+            {
+                auto deadline = std::chrono::steady_clock::now() + slice;
+                while (!done())
+                {
+                    for (auto n = stride; n != 0 && !done(); --n)
+                        visit(callable);
+                    if (std::chrono::steady_clock::now() >= deadline)
+                        break;
+                }
+                return done();
+            }
+            void restart()
+            {
+                current = tree->begin(order_t{}, dir_t{});
+                modifications = tree->modification_count();
+                visited_ = 0;
+            }
+
+            bool done() const
+            {
+                return !current;
+            }
+            bool valid() const
+            {
+                return modifications == tree->modification_count();
+            }
+            std::size_t visited() const
+            {
+                return visited_;
+            }
+
+        private:
+            void check() const
+            {
+                if (!valid())
+                    throw traversal_invalidated();
+            }
+            template <typename Callable>
+            void visit(Callable &callable)
+            {
+                check();
+                auto position = current++;
+                ++visited_;
+                DS_EXP_TRACE_VISIT();
+                callable(*position);
+            }
+
+            tree_t *tree;
+            iterator current;
+            std::size_t modifications;
+            std::size_t visited_ = 0;
+        };
+
+        template <typename tree_t, typename order_t, typename dir_t = left_first_t>
+        auto make_resumable_traversal(tree_t &tree, order_t order, dir_t dir = dir_t{})
+        {
+            return resumable_traversal<tree_t, order_t, dir_t>(tree, order, dir);
+        }
+    }
+}
+
+#endif //INC_201703_RESUMABLE_TRAVERSAL_HPP
@@ -19,6 +19,7 @@ namespace ds_exp
         std::ostream &escape(std::ostream &out, T const &t, Escaped ...escaped)
         {
             std::ostringstream stream;
+            stream.copyfmt(out);
             stream << t;
             auto output = stream.str();
             for (auto iter = output.begin(); iter != output.end(); ++iter)
@@ -0,0 +1,481 @@
+#ifndef INC_201703_SNAPSHOT_HPP
+#define INC_201703_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "parallel.hpp"
+#include "crc32c.hpp"
+
+namespace ds_exp
+{
+    inline namespace archive
+    {
+        struct snapshot_corrupt : std::domain_error
+        {
+            explicit snapshot_corrupt(std::string const &what)
+                : domain_error("Corrupt snapshot: " + what + ".")
+            {
+            }
+        };
+
+        constexpr std::size_t default_block_size = std::size_t(1) << 18;
+        constexpr std::size_t max_block_size = std::size_t(1) << 26;
+
+        namespace detail
+        {
+            constexpr std::size_t min_match = 4;
+            constexpr std::size_t max_offset = 65535;
+            constexpr unsigned hash_bits = 14;
+
+            inline std::uint32_t read32(char const *p)
+            {
+                std::uint32_t v;
+                std::memcpy(&v, p, sizeof v);
+                return v;
+            }
+            inline std::uint32_t hash32(std::uint32_t v)
+            {
+                return (v * 2654435761u) >> (32 - hash_bits);
+            }
+            inline void put_length(std::string &out, std::size_t length)
+            {
+                for (; length >= 255; length -= 255)
+                    out.push_back(static_cast<char>(255));
+                out.push_back(static_cast<char>(length));
+            }
+            inline std::size_t get_length(std::string_view in, std::size_t &ip, std::size_t length)
+            {
+                if (length != 15)
+                    return length;
+                for (unsigned char extra = 255; extra == 255; length += extra)
+                {
+                    if (ip == in.size())
+                        throw snapshot_corrupt("truncated length");
+                    extra = static_cast<unsigned char>(in[ip++]);
+                }
+                return length;
+            }
+            inline void put_sequence(std::string &out, char const *literals, std::size_t literal_count,
+                                     std::size_t offset, std::size_t match)
+            {
+                auto extra_match = match ? match - min_match : 0;
+                out.push_back(static_cast<char>((std::min<std::size_t>(literal_count, 15) << 4) |
+                                                std::min<std::size_t>(extra_match, 15)));
+                if (literal_count >= 15)
+                    put_length(out, literal_count - 15);
+                out.append(literals, literal_count);
+                if (!match)
+                    return;
+                out.push_back(static_cast<char>(offset & 0xff));
+                out.push_back(static_cast<char>(offset >> 8));
+                if (extra_match >= 15)
+                    put_length(out, extra_match - 15);
+            }
+            template <typename T>
+            void put_integer(std::ostream &out, T value)
+            {
+                char bytes[sizeof(T)];
+                for (std::size_t i = 0; i < sizeof(T); ++i)
+                    bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+                out.write(bytes, sizeof bytes);
+            }
+            inline std::uint32_t block_checksum(std::uint32_t size, std::uint32_t stored, bool packed,
+                                                std::string_view data)
+            {
+                char header[9];
+                for (std::size_t i = 0; i < 4; ++i)
+                {
+                    header[i] = static_cast<char>((size >> (8 * i)) & 0xff);
+                    header[4 + i] = static_cast<char>((stored >> (8 * i)) & 0xff);
+                }
+                header[8] = packed ? 1 : 0;
+                return crc32c(data, crc32c(std::string_view(header, sizeof header)));
+            }
+            template <typename T>
+            T get_integer(std::istream &in)
+            {
+                unsigned char bytes[sizeof(T)];
+                if (!in.read(reinterpret_cast<char *>(bytes), sizeof bytes))
+                    throw snapshot_corrupt("truncated header");
+                T value = 0;
+                for (std::size_t i = 0; i < sizeof(T); ++i)
+                    value |= static_cast<T>(bytes[i]) << (8 * i);
+                return value;
+            }
+        }
+
+        inline void lz_compress(std::string_view in, std::string &out)
+        {
+            using namespace detail;
+            std::vector<std::uint32_t> table(std::size_t(1) << hash_bits);
+            std::size_t pos = 0, anchor = 0;
+            while (pos + min_match <= in.size())
+            {
+                auto current = read32(in.data() + pos);
+                auto &slot = table[hash32(current)];
+                auto candidate = static_cast<std::size_t>(slot);
+                slot = static_cast<std::uint32_t>(pos + 1);
+                if (candidate-- == 0 || pos - candidate > max_offset || read32(in.data() + candidate) != current)
+                {
+                    ++pos;
+                    continue;
+                }
+                auto match = min_match;
+                while (pos + match < in.size() && in[candidate + match] == in[pos + match])
+                    ++match;
+                put_sequence(out, in.data() + anchor, pos - anchor, pos - candidate, match);
+                pos += match;
+                anchor = pos;
+            }
+            put_sequence(out, in.data() + anchor, in.size() - anchor, 0, 0);
+        }
+
+        inline void lz_decompress(std::string_view in, char *out, std::size_t size)
+        {
+            using namespace detail;
+            std::size_t ip = 0, op = 0;
+            while (ip < in.size())
+            {
+                auto token = static_cast<unsigned char>(in[ip++]);
+                auto literals = get_length(in, ip, token >> 4);
+                if (literals > in.size() - ip || literals > size - op)
+                    throw snapshot_corrupt("literal run out of bounds");
+                std::memcpy(out + op, in.data() + ip, literals);
+                ip += literals, op += literals;
+                if (ip == in.size())
+                    break;
+                if (in.size() - ip < 2)
+                    throw snapshot_corrupt("truncated offset");
+                auto offset = static_cast<std::size_t>(static_cast<unsigned char>(in[ip])) |
+                              static_cast<std::size_t>(static_cast<unsigned char>(in[ip + 1])) << 8;
+                ip += 2;
+                auto match = get_length(in, ip, token & 15) + min_match;
+                if (offset == 0 || offset > op || match > size - op)
+                    throw snapshot_corrupt("match out of bounds");
+                for (auto from = op - offset; match; --match)
+                    out[op++] = out[from++];
+            }
+            if (op != size)
+                throw snapshot_corrupt("block size mismatch");
+        }
+
+        class snapshot_writer : public std::streambuf
+        {
+        public:
+            explicit snapshot_writer(std::ostream &out, std::size_t block_size = default_block_size, bool compress = true)
+                : out(out), block(std::clamp<std::size_t>(block_size, 1, max_block_size)), compress(compress)
+            {
+                out.write(magic, sizeof magic);
+                detail::put_integer<std::uint32_t>(out, static_cast<std::uint32_t>(block.size()));
+                setp(block.data(), block.data() + block.size());
+            }
+            snapshot_writer(snapshot_writer const &) = delete;
+            snapshot_writer &operator=(snapshot_writer const &) = delete;
+            ~snapshot_writer() override
+            {
+                if (!finished)
+                    finish();
+            }
+
+            void finish()
+            {
+                flush_block();
+                detail::put_integer<std::uint32_t>(out, 0);
+                out.flush();
+                finished = true;
+            }
+            std::size_t raw_bytes() const
+            {
+                return raw;
+            }
+            std::size_t stored_bytes() const
+            {
+                return stored;
+            }
+
+            static constexpr char magic[4] = {'D', 'S', 'X', 'C'};
+
+        protected:
+            int_type overflow(int_type c) override
+            {
+                flush_block();
+                if (!traits_type::eq_int_type(c, traits_type::eof()))
+                {
+                    *pptr() = traits_type::to_char_type(c);
+                    pbump(1);
+                }
+                return traits_type::not_eof(c);
+            }
+            int sync() override
+            {
+                return 0;
+            }
+
+        private:
+            void flush_block()
+            {
+                auto size = static_cast<std::size_t>(pptr() - pbase());
+                if (!size)
+                    return;
+                compressed.clear();
+                if (compress)
+                    lz_compress(std::string_view(pbase(), size), compressed);
+                bool packed = compress && compressed.size() < size;
+                auto data = packed ? std::string_view(compressed) : std::string_view(pbase(), size);
+                auto raw_size = static_cast<std::uint32_t>(size), stored_size = static_cast<std::uint32_t>(data.size());
+                detail::put_integer(out, raw_size);
+                detail::put_integer(out, stored_size);
+                out.put(packed ? 1 : 0);
+                detail::put_integer(out, detail::block_checksum(raw_size, stored_size, packed, data));
+                out.write(data.data(), static_cast<std::streamsize>(data.size()));
+                raw += size;
+                stored += data.size() + 13;
+                setp(block.data(), block.data() + block.size());
+            }
+
+            std::ostream &out;
+            std::vector<char> block;
+            std::string compressed;
+            bool compress;
+            std::size_t raw = 0, stored = sizeof magic + 8;
+            bool finished = false;
+        };
+
+        class snapshot_reader : public std::streambuf
+        {
+        public:
+            explicit snapshot_reader(std::istream &in, unsigned threads = default_concurrency())
+                : in(in), batch(threads ? threads : 1)
+            {
+                char magic[sizeof snapshot_writer::magic];
+                if (!in.read(magic, sizeof magic) || std::memcmp(magic, snapshot_writer::magic, sizeof magic) != 0)
+                    throw snapshot_corrupt("bad magic");
+                block_size = detail::get_integer<std::uint32_t>(in);
+                if (block_size == 0 || block_size > max_block_size)
+                    throw snapshot_corrupt("bad block size");
+                producer = std::thread([this]
+                {
+                    produce();
+                });
+            }
+            snapshot_reader(snapshot_reader const &) = delete;
+            snapshot_reader &operator=(snapshot_reader const &) = delete;
+            ~snapshot_reader() override
+            {
+                {
+                    std::lock_guard lock(mutex);
+                    stopping = true;
+                }
+                space.notify_all();
+                if (producer.joinable())
+                    producer.join();
+            }
+
+            void finish()
+            {
+                do
+                    setg(egptr(), egptr(), egptr());
+                while (!traits_type::eq_int_type(underflow(), traits_type::eof()));
+                if (producer.joinable())
+                    producer.join();
+                if (error)
+                    std::rethrow_exception(std::exchange(error, nullptr));
+            }
+
+        protected:
+            int_type underflow() override
+            {
+                if (gptr() < egptr())
+                    return traits_type::to_int_type(*gptr());
+                std::unique_lock lock(mutex);
+                available.wait(lock, [this]
+                {
+                    return !ready.empty() || produced;
+                });
+                if (ready.empty())
+                    return traits_type::eof();
+                auto next = std::move(ready.front());
+                ready.pop_front();
+                lock.unlock();
+                space.notify_one();
+                auto kept = std::min<std::size_t>(putback_size, egptr() - eback());
+                base += static_cast<std::size_t>(egptr() - eback()) - kept;
+                std::copy(egptr() - kept, egptr(), next.data() + putback_size - kept);
+                current = std::move(next);
+                auto first = current.data() + putback_size;
+                setg(first - kept, first, current.data() + current.size());
+                return traits_type::to_int_type(*gptr());
+            }
+            pos_type seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which) override
+            {
+                if (way != std::ios_base::cur)
+                    return pos_type(off_type(-1));
+                return seekpos(pos_type(static_cast<off_type>(base + (gptr() - eback())) + off), which);
+            }
+            pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+            {
+                auto target = static_cast<off_type>(pos);
+                if (!(which & std::ios_base::in) || target < static_cast<off_type>(base) ||
+                    target > static_cast<off_type>(base + (egptr() - eback())))
+                    return pos_type(off_type(-1));
+                setg(eback(), eback() + (target - static_cast<off_type>(base)), egptr());
+                return pos;
+            }
+
+        private:
+            static constexpr std::size_t putback_size = 4096;
+
+            struct block_entry
+            {
+                std::uint32_t size;
+                bool packed;
+                std::uint32_t checksum;
+                std::string data;
+            };
+
+            void produce()
+            {
+                try
+                {
+                    std::size_t index = 0;
+                    for (bool last = false; !last;)
+                    {
+                        std::vector<block_entry> blocks;
+                        while (blocks.size() < batch)
+                        {
+                            auto size = detail::get_integer<std::uint32_t>(in);
+                            if (!size)
+                            {
+                                last = true;
+                                break;
+                            }
+                            auto stored = detail::get_integer<std::uint32_t>(in);
+                            auto packed = in.get();
+                            auto checksum = detail::get_integer<std::uint32_t>(in);
+                            if (size > block_size || (packed != 0 && packed != 1) || (packed ? stored >= size : stored != size))
+                                throw snapshot_corrupt("bad block header");
+                            block_entry entry{size, packed == 1, checksum, std::string(stored, '\0')};
+                            if (!in.read(entry.data.data(), stored))
+                                throw snapshot_corrupt("truncated block");
+                            blocks.push_back(std::move(entry));
+                        }
+                        std::vector<std::string> decoded(blocks.size());
+                        std::vector<std::exception_ptr> errors(blocks.size());
+                        parallel_for(blocks.size(), static_cast<unsigned>(batch), [&](std::size_t i)
+                        {
+                            auto &b = blocks[i];
+                            try
+                            {
+                                auto stored = static_cast<std::uint32_t>(b.data.size());
+                                if (detail::block_checksum(b.size, stored, b.packed, b.data) != b.checksum)
+                                    throw snapshot_corrupt("checksum mismatch in block " + std::to_string(index + i));
+                                decoded[i].resize(putback_size + b.size);
+                                if (b.packed)
+                                    lz_decompress(b.data, decoded[i].data() + putback_size, b.size);
+                                else
+                                    std::memcpy(decoded[i].data() + putback_size, b.data.data(), b.size);
+                            }
+                            catch (...)
+                            {
+                                errors[i] = std::current_exception();
+                            }
+                        });
+                        for (std::size_t i = 0; i < blocks.size(); ++i, ++index)
+                        {
+                            if (errors[i])
+                                std::rethrow_exception(errors[i]);
+                            std::unique_lock lock(mutex);
+                            space.wait(lock, [this]
+                            {
+                                return stopping || ready.size() < 2 * batch;
+                            });
+                            if (stopping)
+                                return;
+                            ready.push_back(std::move(decoded[i]));
+                            available.notify_one();
+                        }
+                    }
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                std::lock_guard lock(mutex);
+                produced = true;
+                available.notify_one();
+            }
+
+            std::istream &in;
+            std::size_t batch;
+            std::uint32_t block_size = 0;
+            std::size_t base = 0;
+            std::string current;
+            std::deque<std::string> ready;
+            std::mutex mutex;
+            std::condition_variable available, space;
+            bool produced = false, stopping = false;
+            std::exception_ptr error;
+            std::thread producer;
+        };
+
+        inline std::string read_snapshot(std::istream &in, unsigned threads = default_concurrency())
+        {
+            snapshot_reader reader(in, threads);
+            std::string result;
+            char buffer[4096];
+            while (auto count = reader.sgetn(buffer, sizeof buffer))
+                result.append(buffer, static_cast<std::size_t>(count));
+            reader.finish();
+            return result;
+        }
+
+        template <typename T>
+        std::pair<std::size_t, std::size_t> save_snapshot(std::ostream &out, T const &object,
+                                                          std::size_t block_size = default_block_size,
+                                                          bool compress = true)
+        {
+            snapshot_writer writer(out, block_size, compress);
+            std::ostream stream(&writer);
+            stream << object;
+            writer.finish();
+            return {writer.raw_bytes(), writer.stored_bytes()};
+        }
+        template <typename T>
+        void load_snapshot(std::istream &in, T &object, unsigned threads = default_concurrency())
+        {
+            snapshot_reader reader(in, threads);
+            std::istream stream(&reader);
+            T loaded;
+            bool parsed;
+            try
+            {
+                parsed = static_cast<bool>(stream >> loaded);
+            }
+            catch (...)
+            {
+                reader.finish();
+                throw;
+            }
+            reader.finish();
+            if (!parsed)
+                throw snapshot_corrupt("payload does not parse");
+            object = std::move(loaded);
+        }
+    }
+}
+
+#endif //INC_201703_SNAPSHOT_HPP
@@ -0,0 +1,134 @@
+#ifndef INC_201703_SUBTREE_INDEX_HPP
+#define INC_201703_SUBTREE_INDEX_HPP
+
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string_view>
+#include <vector>
+#include "binary_tree.hpp"
+#include "tree_parse.hpp"
+#include "save_load.hpp"
+
+namespace ds_exp
+{
+    inline namespace tree
+    {
+        struct subtree_index
+        {
+            std::size_t stride = 1;
+            std::size_t nodes = 0;
+            std::vector<std::streamoff> offsets;
+
+            friend std::ostream &operator<<(std::ostream &out, subtree_index const &index)
+            {
+                out << index.stride << " " << index.nodes << " " << index.offsets.size();
+                for (auto offset : index.offsets)
+                    out << " " << offset;
+                return out;
+            }
+            friend std::istream &operator>>(std::istream &in, subtree_index &index)
+            {
+                std::size_t count = 0;
+                if (!(in >> index.stride >> index.nodes >> count) || index.stride == 0)
+                {
+                    in.setstate(std::ios::failbit);
+                    return in;
+                }
+                index.offsets.resize(count);
+                for (auto &offset : index.offsets)
+                    in >> offset;
+                return in;
+            }
+        };
+
+        namespace detail
+        {
+            template <typename Iter>
+            void print_indexed(std::ostream &out, Iter iter, subtree_index &index, std::streamoff &offset,
+                               std::ostringstream &piece)
+            {
+                auto put = [&](std::string_view text)
+                {
+                    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+                    offset += static_cast<std::streamoff>(text.size());
+                };
+                if (!iter)
+                    return put("null");
+                if (index.nodes++ % index.stride == 0)
+                    index.offsets.push_back(offset);
+                piece.str(std::string{});
+                piece << "(";
+                escape(piece, *iter, ')') << "),";
+                put(piece.str());
+                print_indexed(out, iter.first_child(), index, offset, piece);
+                put(",");
+                print_indexed(out, iter.second_child(), index, offset, piece);
+            }
+
+            inline void skip_nodes(std::istream &in, std::size_t count)
+            {
+                for (;;)
+                {
+                    parse::detail::eat_space(in);
+                    while (in.peek() == ',')
+                        in.get(), parse::detail::eat_space(in);
+                    auto start = in.tellg();
+                    auto c = in.peek();
+                    if (!in || c == ']')
+                        throw parse::expect_failed("element");
+                    bool node = true;
+                    if (c == '(')
+                    {
+                        in.get();
+                        for (auto ch = in.get(); ch != ')'; ch = in.get())
+                        {
+                            if (!in)
+                                throw parse::expect_failed(")");
+                            if (ch == '\\' && in.peek() == ')')
+                                in.get();
+                        }
+                    } else
+                    {
+                        node = !parse::detail::read_word(in, "null");
+                        parse::detail::read_until(in, false, ',', ']');
+                    }
+                    if (node && count-- == 0)
+                    {
+                        in.seekg(start);
+                        return;
+                    }
+                }
+            }
+        }
+
+        template <typename T>
+        subtree_index save_indexed(std::ostream &out, binary_tree<T> const &tree, std::size_t stride = 1)
+        {
+            subtree_index index;
+            index.stride = stride ? stride : 1;
+            std::ostringstream piece;
+            piece.copyfmt(out);
+            std::streamoff offset = 1;
+            out << "[";
+            detail::print_indexed(out, tree.begin(preorder), index, offset, piece);
+            out << "]";
+            return index;
+        }
+
+        template <typename T, typename direction = left_first_t>
+        std::optional<binary_tree<T>> load_subtree(std::istream &in, subtree_index const &index, std::size_t rank)
+        {
+            if (rank >= index.nodes || rank / index.stride >= index.offsets.size())
+                return std::nullopt;
+            parse::detail::eat_space(in);
+            auto start = in.tellg();
+            in.seekg(start + index.offsets[rank / index.stride]);
+            detail::skip_nodes(in, rank % index.stride);
+            return tree_parse<direction, T>(in).get_preorder_subtree();
+        }
+    }
+}
+
+#endif //INC_201703_SUBTREE_INDEX_HPP
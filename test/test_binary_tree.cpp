@@ -1,7 +1,17 @@
-
+#include <chrono>
+#include <algorithm>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <vector>
 #include "test_binary_tree.hpp"
+#include "test_utility.hpp"
 #include "../binary_tree.hpp"
+#include "../range_adaptors.hpp"
+#include "../lca_index.hpp"
+#include "../subtree_index.hpp"
+#include "../compaction.hpp"
+#include "../resumable_traversal.hpp"
 
 void test_binary_tree()
 {
@@ -70,4 +80,208 @@ void test_binary_tree()
         auto tree2 = tree;
         assert(tree2 == tree);
     }
-}
\ No newline at end of file
+    {
+        std::vector<std::string> in_order{"left left", "left child", "left right", "root", "right child"};
+        auto balanced = binary_tree<std::string>::from_sorted(in_order.begin(), in_order.end());
+        assert(balanced.depth() == 3);
+        assert(std::equal(in_order.begin(), in_order.end(), balanced.begin(inorder)));
+        assert(balanced.begin(postorder).parent().parent() == balanced.root());
+
+        std::vector<std::optional<std::string>> level{"root", "left child", "right child", "left left", "left right"};
+        auto from_level = binary_tree<std::string>::from_level_order(level.begin(), level.end());
+        assert(from_level == tree);
+        assert(from_level.begin(inorder).parent().parent() == from_level.root());
+
+        std::vector<std::string> values{"root", "left child", "left left", "left right", "right child"};
+        std::vector<bool> shape{1, 1, 1, 0, 0, 1, 0, 0, 1, 0, 0};
+        auto from_pre = binary_tree<std::string>::from_preorder(values.begin(), values.end(), shape.begin(), shape.end());
+        assert(from_pre == tree);
+        assert(*from_pre.root().second_child() == "right child");
+        assert(from_pre.begin(postorder).parent().parent() == from_pre.root());
+
+        std::vector<std::optional<std::string>> orphaned{"root", std::nullopt, std::nullopt, "orphan"};
+        assert(throws<precondition_failed_to_satisfy>([&] { binary_tree<std::string>::from_level_order(orphaned.begin(), orphaned.end()); }));
+        std::vector<bool> truncated(shape.begin(), shape.end() - 1), extended(shape);
+        extended.push_back(0);
+        assert(throws<precondition_failed_to_satisfy>([&] { binary_tree<std::string>::from_preorder(values.begin(), values.end(), truncated.begin(), truncated.end()); }));
+        assert(throws<precondition_failed_to_satisfy>([&] { binary_tree<std::string>::from_preorder(values.begin(), values.end(), extended.begin(), extended.end()); }));
+        assert(throws<precondition_failed_to_satisfy>([&] { binary_tree<std::string>::from_preorder(values.begin(), values.end() - 1, shape.begin(), shape.end()); }));
+        assert(throws<precondition_failed_to_satisfy>([&] { binary_tree<std::string>::from_preorder(values.begin(), values.begin(), shape.begin(), shape.end()); }));
+    }
+    {
+        std::vector<int> sorted(15);
+        for (int i = 0; i < 15; ++i)
+            sorted[i] = i + 1;
+        auto numbers = binary_tree<int>::from_sorted(sorted.begin(), sorted.end());
+        int visited = 0;
+        std::vector<int> result;
+        for (auto value : tree_iterate(numbers, inorder) | filter([&](int v)
+        {
+            ++visited;
+            return v % 2 == 0;
+        }) | transform([](int v)
+        {
+            return v * 10;
+        }) | take(3))
+            result.push_back(value);
+        assert((result == std::vector<int>{20, 40, 60}) && visited == 6);
+
+        auto left = numbers.root(inorder).first_child(left_child);
+        result.assign(numbers.subtree(left).begin(), numbers.subtree(left).end());
+        assert((result == std::vector<int>{4, 2, 1, 3, 6, 5, 7}));
+        result.clear();
+        for (auto &value : numbers.subtree(left, inorder) | take_while([](int v)
+        {
+            return v < 5;
+        }))
+            result.push_back(value);
+        assert((result == std::vector<int>{1, 2, 3, 4}));
+        for (auto &value : numbers.subtree(left, postorder) | filter([](int v)
+        {
+            return v > 5;
+        }))
+            value = -value;
+        result.assign(numbers.subtree(left, inorder).begin(), numbers.subtree(left, inorder).end());
+        assert((result == std::vector<int>{1, 2, 3, 4, 5, -6, -7}));
+    }
+    {
+        std::vector<int> sorted(15);
+        for (int i = 0; i < 15; ++i)
+            sorted[i] = i + 1;
+        auto numbers = binary_tree<int>::from_sorted(sorted.begin(), sorted.end());
+        auto at = [&](int v)
+        {
+            return &*std::find(numbers.begin(), numbers.end(), v);
+        };
+        auto index = make_lca_index(numbers);
+        assert(index.size() == 15 && index.depth(at(8)) == 0 && index.depth(at(1)) == 3);
+        assert(*index.lowest_common_ancestor(at(1), at(3)) == 2);
+        assert(*index.lowest_common_ancestor(at(1), at(7)) == 4);
+        assert(*index.lowest_common_ancestor(at(5), at(12)) == 8);
+        assert(*index.lowest_common_ancestor(at(6), at(6)) == 6);
+        assert(index.is_ancestor(at(4), at(7)) && !index.is_ancestor(at(7), at(4)) && !index.is_ancestor(at(9), at(7)));
+        assert(index.distance(at(1), at(7)) == 4 && index.distance(at(1), at(15)) == 6);
+        assert(*index.ancestor(at(1), 3) == 8 && index.ancestor(at(1), 4) == nullptr);
+        std::vector<int> path;
+        for (auto element : index.path(at(1), at(7)))
+            path.push_back(*element);
+        assert((path == std::vector<int>{1, 2, 4, 6, 7}));
+        for (auto a = numbers.begin(); a; ++a)
+            for (auto b = numbers.begin(); b; ++b)
+            {
+                auto ancestor = a;
+                while (!index.is_ancestor(ancestor, b))
+                    ancestor = ancestor.parent();
+                assert(index.lowest_common_ancestor(a, b) == &*ancestor);
+            }
+
+        auto moved = numbers.replace_child(numbers.root(), binary_tree<int>{}, left_child);
+        assert(index.stale() && index.size() == 8);
+        assert(*index.lowest_common_ancestor(at(9), at(15)) == 12);
+        bool rejected = false;
+        try
+        {
+            index.depth(&*moved.root());
+        }
+        catch (node_not_indexed const &)
+        {
+            rejected = true;
+        }
+        assert(rejected);
+    }
+    {
+        std::vector<int> sorted(15);
+        for (int i = 0; i < 15; ++i)
+            sorted[i] = i + 1;
+        auto numbers = binary_tree<int>::from_sorted(sorted.begin(), sorted.end());
+        std::stringstream saved, plain;
+        saved << "header ";
+        auto index = save_indexed(saved, numbers, 4);
+        plain << "header " << numbers;
+        assert(saved.str() == plain.str() && index.nodes == 15 && index.offsets.size() == 4);
+        std::stringstream index_text;
+        index_text << index;
+        subtree_index reloaded;
+        index_text >> reloaded;
+        assert(index_text && reloaded.offsets == index.offsets);
+
+        auto values_of = [](std::optional<binary_tree<int>> const &tree)
+        {
+            return std::vector<int>(tree->begin(inorder), tree->end(inorder));
+        };
+        for (auto [rank, expected] : {std::pair{1, std::vector<int>{1, 2, 3, 4, 5, 6, 7}}, {5, {5, 6, 7}},
+                                      {8, {9, 10, 11, 12, 13, 14, 15}}, {14, {15}}, {0, sorted}})
+        {
+            saved.clear();
+            saved.seekg(7);
+            auto loaded = load_subtree<int>(saved, reloaded, rank);
+            assert(values_of(loaded) == expected);
+        }
+        saved.seekg(7);
+        auto past_end = load_subtree<int>(saved, reloaded, 15);
+        assert(!past_end);
+
+        binary_tree<std::string> words;
+        words.set_root("a)b");
+        words.new_child(words.root(), "c, d", left_child);
+        words.new_child(words.root().first_child(left_child), "e)", right_child);
+        std::stringstream saved_words;
+        auto word_index = save_indexed(saved_words, words, 2);
+        auto subtree = load_subtree<std::string>(saved_words, word_index, 2);
+        assert(subtree && *subtree->root() == "e)" && subtree->size() == 1);
+    }
+    {
+        std::vector<int> sorted(200);
+        for (int i = 0; i < 200; ++i)
+            sorted[i] = i;
+        auto numbers = binary_tree<int>::from_sorted(sorted.begin(), sorted.end());
+        auto copy = numbers;
+        auto old = std::find(numbers.begin(), numbers.end(), 37);
+        auto before = numbers.modification_count();
+        auto compaction = make_tree_compaction(numbers, inorder, left_first, true);
+        auto finished = compaction.resume(150);
+        assert(!finished && compaction.relocated() == 150 && numbers.modification_count() != before);
+        assert(numbers == copy);
+        finished = compaction.resume_for(std::chrono::seconds(10), 16);
+        assert(!finished || compaction.done());
+        compaction.resume(100);
+        assert(compaction.done() && compaction.relocated() == 200 && numbers == copy);
+        auto moved = compaction.remap(old);
+        assert(moved && *moved == 37 && &*moved != &*old && *moved.parent() == *std::find(copy.begin(), copy.end(), 37).parent());
+        compaction.release();
+
+        auto interrupted = make_tree_compaction(numbers, preorder);
+        interrupted.resume(10);
+        numbers.rotate_up(numbers.root().first_child());
+        bool rejected = false;
+        try
+        {
+            interrupted.resume(10);
+        }
+        catch (traversal_invalidated const &)
+        {
+            rejected = true;
+        }
+        assert(rejected && interrupted.relocated() == 10);
+        old = std::find(numbers.begin(), numbers.end(), 120);
+        auto compacted = compact(numbers, postorder, left_first, true);
+        assert(std::vector<int>(numbers.begin(inorder), numbers.end(inorder)) == sorted);
+        assert(compacted.done() && compacted.relocated() == 200 && *compacted.remap(old) == 120);
+    }
+    {
+        static_assert(std::is_nothrow_move_constructible_v<binary_tree<std::string>> &&
+                      std::is_nothrow_move_assignable_v<binary_tree<std::string>>);
+        auto receiver = tree, donor = tree, spliced = tree;
+        auto donor_traversal = make_resumable_traversal(donor, preorder);
+        auto spliced_traversal = make_resumable_traversal(spliced, preorder);
+        receiver.replace_child(receiver.root(), std::move(donor), left_child);
+        receiver.splice(receiver.root(), std::move(spliced), right_child, receiver.begin(postorder), left_child);
+        assert(!donor_traversal.valid() && !spliced_traversal.valid() && receiver.depth() == 5);
+
+        binary_tree<std::string> lone, leaf;
+        lone.set_root("root");
+        leaf.set_root("leaf");
+        lone.splice(lone.root(), std::move(leaf), left_child, lone.root(), left_child);
+        assert(lone.size() == 2 && *lone.root().first_child(left_child) == "leaf");
+    }
+}
@@ -0,0 +1,40 @@
+#include <sstream>
+#include <string>
+#include "test_console_ui.hpp"
+#include "../console_ui.hpp"
+
+void test_console_ui()
+{
+    using namespace ds_exp;
+    console_ui<std::string, int> ui;
+    std::istringstream script("create [(root,1),(left,2),null,null,(right,3),null,null]\n"
+                              "value root\n"
+                              "assign (left) 20\n"
+                              "value left\n"
+                              "# comment\n"
+                              "\n"
+                              "value missing\n"
+                              "child root right\n"
+                              "sibling left right\n"
+                              "parent root\n"
+                              "insert right left [(new,4),null,null]\n"
+                              "traverse in\n"
+                              "delete root left\n"
+                              "depth\n"
+                              "bogus\n"
+                              "quit\n"
+                              "value root");
+    std::ostringstream output;
+    auto report = ui.execute_batch(script, output, 16);
+    assert(report.commands == 13 && report.failures == 2);
+    assert(output.str() == "1\n20\nerror: no such key\nright,3\nright,3\nnull\nleft,20 root,1 new,4 right,3 \n3\n"
+                           "error: unknown command\n");
+
+    console_ui<int, std::string> numbers;
+    std::istringstream interactive("create [(1,one),null,(2,two),null,null]\nvalue 2\nassign 1 (first one)\n"
+                                   "assign 2 second (two)\nprint\n");
+    std::ostringstream shown;
+    numbers.execute(interactive, shown);
+    assert(shown.str().find("> two\n") != std::string::npos);
+    assert(numbers.adapter().Value(1) == "first one" && numbers.adapter().Value(2) == "second (two)");
+}
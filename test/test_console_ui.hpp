@@ -0,0 +1,5 @@
+#ifndef INC_201703_TEST_CONSOLE_UI_HPP
+#define INC_201703_TEST_CONSOLE_UI_HPP
+
+void test_console_ui();
+#endif //INC_201703_TEST_CONSOLE_UI_HPP
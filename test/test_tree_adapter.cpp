@@ -1,5 +1,45 @@
+#include <algorithm>
+#include <chrono>
 #include "test_tree_adapter.hpp"
+#include "test_utility.hpp"
 #include "../tree_adapter.hpp"
+#include "../key_dictionary.hpp"
+#include "../ordered_adapter.hpp"
+#include "../key_scan.hpp"
+#include "../tree_store.hpp"
+#include "../snapshot.hpp"
+#include "../workload.hpp"
+
+namespace
+{
+    struct copy_counted
+    {
+        static inline int copies = 0;
+        int value = 0;
+        copy_counted() = default;
+        explicit copy_counted(int value)
+            : value(value)
+        {
+        }
+        copy_counted(copy_counted const &src)
+            : value(src.value)
+        {
+            ++copies;
+        }
+        copy_counted(copy_counted &&) = default;
+        copy_counted &operator=(copy_counted const &src)
+        {
+            value = src.value;
+            ++copies;
+            return *this;
+        }
+        copy_counted &operator=(copy_counted &&) = default;
+        friend std::istream &operator>>(std::istream &in, copy_counted &c)
+        {
+            return in >> c.value;
+        }
+    };
+}
 
 void test_tree_adapter()
 {
@@ -24,7 +64,30 @@ void test_tree_adapter()
     assert(get_value(*adapter.Child("left", left_child)) == 3);
     assert(get_value(*adapter.Child("right", right_child)) == 5);
     assert(get_value(*adapter.Sibling("left", right_child)) == 4);
+    assert(!adapter.TryValue("missing") && *adapter.TryValue("right") == 4);
+    assert(!adapter.TryAssign("missing", 0) && adapter.TryAssign("right", 4));
+    assert(!adapter.TryParent("missing") && *adapter.TryParent("left") == adapter.Root());
+    assert(!adapter.TryChild("missing", left_child) && !*adapter.TryChild("left left", left_child));
+    assert(!adapter.TrySibling("missing", right_child) && get_value(**adapter.TrySibling("left", right_child)) == 4);
+    assert(!adapter.try_get_iterator("missing") && *adapter.try_get_iterator("root") == adapter.Root());
+    {
+        decltype(adapter) absent;
+        bool thrown = false;
+        try
+        {
+            absent.try_get_iterator("root");
+        }
+        catch (decltype(absent)::tree_not_exist const &)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    char const *left_left = "left left";
+    assert(adapter.Value(left_left) == 3 && adapter.Value("left left"sv) == 3 && !adapter.TryValue("left"sv.substr(1)));
     assert(get_value(*adapter.Sibling("right", left_child)) == 2);
+    assert(get_value(*adapter.Child<right_t>("right")) == 5 && adapter.Value<inorder_t>("left") == 2);
+    adapter.Assign<int>("left", 2);
     auto right_node = adapter.Child("root", right_child);
     decltype(adapter) new_adapter;
     new_adapter.CreateBiTree(definition);
@@ -40,4 +103,512 @@ void test_tree_adapter()
     adapter.InsertChild(right_node, replaced, right_child);
     equals.CreateBiTree(definition);
     assert(adapter == equals);
+    {
+        using key_t = interned<std::string>;
+        tree_adapter<key_t, int> interned_adapter;
+        interned_adapter.CreateBiTree(definition);
+        assert(interned_adapter.Value("left left") == 3);
+        interned_adapter.Assign("left", 5);
+        assert(interned_adapter.Value("left") == 5);
+        assert(get_key(*interned_adapter.Child("right", right_child)) == "right right");
+        assert(key_t("left").id() == get_key(*interned_adapter.Child("root", left_child)).id());
+        std::ostringstream dictionary_out, tree_out;
+        key_t::dictionary().save(dictionary_out);
+        tree_out << compact_keys << interned_adapter;
+        assert(tree_out.str().find("left") == std::string::npos);
+        std::istringstream dictionary_in(dictionary_out.str()), tree_in(tree_out.str());
+        auto imported = key_t::dictionary().load(dictionary_in);
+        decltype(interned_adapter) loaded;
+        tree_in >> imported >> loaded;
+        assert(loaded == interned_adapter);
+        assert(loaded.Value("left") == 5);
+        auto size = key_t::dictionary().size();
+        assert(!loaded.TryValue("missing") && !loaded.TryParent("missing") && !loaded.TryChild("missing"sv, left_child));
+        assert(key_t::dictionary().size() == size);
+        assert(key_t::resolve("leftover"sv.substr(0, 4))->id() == key_t("left").id());
+        assert(!key_t::resolve(std::string(64, 'k')) && key_t::dictionary().size() == size);
+        std::ostringstream again_out;
+        again_out << compact_keys << loaded;
+        std::istringstream again_in(again_out.str());
+        decltype(interned_adapter) again;
+        again_in >> again;
+        assert(again == interned_adapter);
+
+        using other_key_t = interned<std::string, struct other_dictionary>;
+        other_key_t prior("prior"), shared("right right");
+        std::istringstream other_dictionary_in(dictionary_out.str()), other_tree_in(tree_out.str());
+        tree_adapter<other_key_t, int> other_loaded;
+        other_tree_in >> other_key_t::dictionary().load(other_dictionary_in) >> other_loaded;
+        assert(other_loaded.Value("left") == 5 && other_loaded.Value("right right") == 5);
+        assert(get_key(*other_loaded.Child("right", right_child)).id() == shared.id());
+        assert(get_key(*other_loaded.Child("root", left_child)) == "left");
+        assert(other_key_t::dictionary().get(prior.id()) == "prior");
+    }
+    {
+        copy_counted::copies = 0;
+        tree_adapter<copy_counted> counted_adapter;
+        counted_adapter.CreateBiTree("[(1), (2), null, null, (3), (4), null, null, null]");
+        assert(counted_adapter.BiTreeDepth() == 3);
+        assert(copy_counted::copies == 0);
+        binary_tree<copy_counted> counted_tree;
+        counted_tree.emplace_root(1);
+        auto child = counted_tree.emplace_child(counted_tree.root(), 2, right_child);
+        assert(child->value == 2 && counted_tree.root().second_child() == child);
+        assert(copy_counted::copies == 0);
+    }
+    {
+        decltype(adapter) spliced, inserted;
+        spliced.CreateBiTree(definition);
+        inserted.CreateBiTree("[(new,6), null, (new right,7), null, null]");
+        auto attach = inserted.get_iterator("new right");
+        spliced.InsertChild(spliced.get_iterator("left"), std::move(inserted), left_child, attach, left_child);
+        decltype(adapter) expected;
+        expected.CreateBiTree(
+            R"~([(root,1), (left,2), (new,6), null, (new right,7), (left left,3), null, null, null, null, (right,4), null, (right right,5), null, null])~");
+        assert(spliced == expected);
+        assert(spliced.Parent("left left") == spliced.get_iterator("new right"));
+        assert(spliced.Parent("new") == spliced.get_iterator("left"));
+
+        using rejected = decltype(adapter)::precondition_failed_to_satisfy;
+        decltype(adapter) more;
+        more.CreateBiTree("[(more,8), null, (more right,9), null, null]");
+        assert(throws<rejected>([&] { spliced.InsertChild(spliced.get_iterator("root"), more, left_child,
+                                                          more.get_iterator("more right"), right_child); }));
+        assert(spliced == expected);
+        auto occupied = more;
+        auto occupied_attach = occupied.get_iterator("more");
+        assert(throws<rejected>([&] { spliced.InsertChild(spliced.get_iterator("root"), std::move(occupied), left_child,
+                                                          occupied_attach, right_child); }));
+        assert(spliced == expected);
+        assert(throws<rejected>([&] { spliced.InsertChild(spliced.get_iterator("right"), std::move(more), right_child,
+                                                          spliced.get_iterator("right right"), left_child); }));
+        assert(spliced == expected);
+    }
+    {
+        tree_adapter<std::string, std::string> strings;
+        strings.CreateBiTree("[(short,a), (a key that is too long for the small buffer,b), null, null, null]");
+        auto usage = strings.measure_memory();
+        using node_type = decltype(strings)::tree_type::node_type;
+        assert(usage.nodes == 2);
+        assert(usage.node_bytes() == 2 * sizeof(node_type));
+        assert(usage.value_heap_bytes > std::string("a key that is too long for the small buffer").size());
+        assert(usage.total() > usage.node_bytes() + usage.value_heap_bytes + usage.estimated_allocator_overhead);
+        assert(usage.index_bytes == 0);
+        for (int lookup = 0; lookup < 8; ++lookup)
+            assert(strings.Value("short") == "a");
+        auto indexed = strings.measure_memory();
+        assert(indexed.index_bytes >= 2 * (sizeof(void *) + sizeof(std::uint32_t)));
+        assert(indexed.total() == usage.total() + indexed.index_bytes);
+#ifdef DS_EXP_INSTRUMENT
+        auto before = heap_snapshot();
+        {
+            auto copy = strings;
+            assert(heap_snapshot().live_bytes() == before.live_bytes() + usage.node_bytes());
+        }
+        assert(heap_snapshot().live_bytes() == before.live_bytes());
+#endif
+    }
+    {
+        ordered_tree_adapter<int, std::string, splay_access_t> splayed;
+        for (int key : {4, 2, 6, 1, 3, 5, 7})
+            splayed.Insert(key, std::to_string(key));
+        splayed.Insert(3, "three"s);
+        assert(splayed.Size() == 7 && *splayed.Root() == 3);
+        auto five = splayed.get_iterator(5);
+        assert(splayed.Value(1) == "1" && *splayed.Root() == 1);
+        assert(get_value(*five) == "5" && splayed.Contains(5) && *splayed.Root() == 5);
+        assert(!splayed.Contains(8));
+        std::vector<int> keys;
+        for (auto &element : splayed)
+            keys.push_back(get_key(element));
+        assert((keys == std::vector<int>{1, 2, 3, 4, 5, 6, 7}));
+        assert(std::as_const(splayed).Value(3) == "three" && *splayed.Root() == 5);
+
+        auto plain = ordered_tree_adapter<int>::from_sorted(keys.begin(), keys.end());
+        plain.Value(7);
+        assert(*plain.Root() == 4 && plain.Depth() == 3 && plain.Size() == 7);
+    }
+    {
+        ordered_tree_adapter<std::string, std::string> dictionary;
+        for (auto key : {"pear", "apple", "apricot", "banana", "app", "ap", "b", "apq"})
+            dictionary.Insert(key, "x"s);
+        auto keys_of = [](auto range)
+        {
+            std::vector<std::string> keys;
+            for (auto &element : range)
+                keys.push_back(get_key(element));
+            return keys;
+        };
+        assert((keys_of(dictionary.Prefix("app")) == std::vector<std::string>{"app", "apple"}));
+        assert((keys_of(dictionary.Prefix("ap")) == std::vector<std::string>{"ap", "app", "apple", "apq", "apricot"}));
+        assert((keys_of(dictionary.Range("apple", "b")) == std::vector<std::string>{"apple", "apq", "apricot"}));
+        assert(keys_of(std::as_const(dictionary).Range("b", "banana")) == std::vector<std::string>{"b"});
+        assert(dictionary.Range("z", "a").empty() && dictionary.Prefix("c").empty());
+        assert(dictionary.Prefix("").begin() == dictionary.begin());
+        assert(get_key(*dictionary.LowerBound("apz")) == "b");
+        assert((keys_of(dictionary.Prefix("apples"sv.substr(0, 3))) == std::vector<std::string>{"app", "apple"}));
+        assert(dictionary.Contains("banana"sv) && !dictionary.Contains("bananas"));
+    }
+    {
+        tree_adapter<std::string, int> wide;
+        std::string wide_definition = "[";
+        for (int i = 0; i < 100; ++i)
+            wide_definition += "(key " + std::to_string(i) + "," + std::to_string(i) + "),null,";
+        wide.CreateBiTree(wide_definition + "null]");
+        auto scan = wide.KeyScan();
+        assert(scan.size() == 100 && !scan.find("key 100"s));
+        assert(scan.find("key 42"sv)->value == 42 && scan.find("key 43")->value == 43);
+        for (int i : {0, 3, 4, 7, 8, 63, 99})
+            assert(scan.find("key " + std::to_string(i))->value == i);
+        std::stringstream indexed;
+        auto index = wide.SaveIndexed(indexed, 16);
+        auto tail = decltype(wide)::LoadSubtree(indexed, index, 90);
+        assert(tail.BiTreeDepth() == 10 && get_key(*tail.Root()) == "key 90");
+        indexed.seekg(0);
+        decltype(wide) whole;
+        indexed >> whole;
+        assert(whole == wide);
+        auto compaction = whole.ResumableCompact(preorder, left_first, true);
+        auto old = whole.get_iterator("key 50");
+        compaction.resume(100);
+        assert(compaction.done() && get_value(*compaction.remap(old)) == 50);
+        old = whole.get_iterator("key 20");
+        auto compacted = whole.Compact(inorder, left_first, true);
+        assert(whole == wide && get_value(*compacted.remap(old)) == 20);
+        auto ancestry = wide.AncestorIndex();
+        assert(ancestry.lowest_common_ancestor(scan.find("key 80"), scan.find("key 42"))->value == 42);
+        assert(ancestry.distance(scan.find("key 80"), scan.find("key 42")) == 38);
+        assert(ancestry.ancestor(scan.find("key 99"), 99) == scan.find("key 0"));
+        std::vector<std::uint32_t> lanes(37, 1);
+        lanes[21] = lanes[30] = 5;
+        assert(adapter::detail::scan_fingerprints(lanes.data(), 0, lanes.size(), 5) == 21);
+        assert(adapter::detail::scan_fingerprints(lanes.data(), 22, lanes.size(), 5) == 30);
+        assert(adapter::detail::scan_fingerprints(lanes.data(), 31, lanes.size(), 5) == lanes.size());
+
+        auto pruned = wide;
+        auto pruned_scan = pruned.KeyScan();
+        for (int i = 0; i < 10; ++i)
+            assert(pruned.Value("key " + std::to_string(i * 11)) == i * 11 && !pruned.TryValue("key 100"));
+        auto removed = pruned.DeleteChild(pruned.get_iterator("key 50"), right_child);
+        for (int i = 0; i < 10; ++i)
+            assert((pruned.TryValue("key " + std::to_string(i * 11)) == nullptr) == (i * 11 > 50));
+        auto assigned = pruned.TryAssign("key 44", 440);
+        assert(assigned && removed.Value("key 60") == 60 && pruned.Value("key 44"sv) == 440);
+        assert(pruned_scan.stale() && !scan.stale());
+        bool rejected = false;
+        try
+        {
+            pruned_scan.find("key 42");
+        }
+        catch (traversal_invalidated const &)
+        {
+            rejected = true;
+        }
+        assert(rejected);
+
+        tree_adapter<std::string> names;
+        names.CreateBiTree("[(a), (b), null, null, (c), null, null]");
+        for (int i = 0; i < 5; ++i)
+            assert(names.TryValue("b"));
+        names.Assign("b", "d");
+        assert(!names.TryValue("b") && names.Value("d") == "d");
+
+        static_assert(std::is_nothrow_move_constructible_v<tree_adapter<std::string>> &&
+                      std::is_nothrow_move_assignable_v<tree_adapter<std::string>> &&
+                      std::is_nothrow_move_constructible_v<tree_adapter<std::string, int>>);
+        auto taken = std::move(pruned);
+        assert(taken.Value("key 44") == 440);
+
+        decltype(adapter) renamed;
+        renamed.CreateBiTree(definition);
+        for (int i = 0; i < 5; ++i)
+            assert(renamed.Value("left") == 2);
+        renamed.Traverse([](auto &element)
+        {
+            if (element.key == "left")
+                element.key = "renamed";
+        }, preorder);
+        assert(renamed.TryValue("renamed") && !renamed.TryValue("left"));
+        for (int i = 0; i < 5; ++i)
+            assert(renamed.Value("right") == 4);
+        renamed.get_iterator("right")->key = "moved";
+        assert(renamed.Value("moved") == 4 && !renamed.TryValue("right"));
+    }
+    {
+        decltype(adapter) scanned;
+        scanned.CreateBiTree(definition);
+        auto traversal = scanned.ResumableTraverse(inorder);
+        std::vector<int> values;
+        auto collect = [&](auto &element)
+        {
+            values.push_back(element.value);
+        };
+        auto finished = traversal.resume(collect, 2);
+        assert(!finished && values.size() == 2);
+        scanned.Assign("root", 10);
+        finished = traversal.resume(collect, 100);
+        assert(finished && traversal.visited() == 5);
+        assert(scanned.Value("root") == 10 && std::find(values.begin(), values.end(), 10) != values.end());
+
+        traversal.restart();
+        finished = traversal.resume_for(collect, std::chrono::hours(1), 1);
+        assert(finished && traversal.visited() == 5);
+        traversal.restart();
+        traversal.resume(collect, 1);
+        scanned.DeleteChild(scanned.get_iterator("root"), left_child);
+        bool invalidated = false;
+        try
+        {
+            traversal.resume(collect, 1);
+        }
+        catch (traversal_invalidated const &)
+        {
+            invalidated = true;
+        }
+        assert(invalidated && !traversal.valid());
+    }
+    {
+        tree_store<std::string, int> store(8, 4);
+        for (int i = 0; i < 100; ++i)
+        {
+            decltype(store)::adapter_type tree;
+            tree.CreateBiTree("[(key,"s + std::to_string(i) + "),null,null]");
+            auto inserted = store.insert("tree (" + std::to_string(i) + ")", std::move(tree));
+            assert(inserted);
+        }
+        auto erased = store.erase("tree 7");
+        assert(store.size() == 100 && store.contains("tree (7)") && !erased);
+        auto found = store.batch({"tree (1)", "tree (2)", "missing"}, [](auto const &, auto &tree)
+        {
+            tree.Assign("key", tree.Value("key") * 10);
+        });
+        assert(found == 2);
+        decltype(store)::adapter_type awkward;
+        awkward.CreateBiTree("[(line\nbreak,7),null,null]");
+        awkward.Assign("line\nbreak", 7);
+        store.insert_or_assign("back\\slash\\)\nname", std::move(awkward));
+        int total = 0;
+        store.read("tree (2)", [&](auto const &tree)
+        {
+            total = tree.Value("key");
+        });
+        assert(total == 20);
+
+        std::stringstream saved;
+        store.save(saved);
+        tree_store<std::string, int> loaded(3, 2);
+        auto records = loaded.load(saved);
+        assert(records == 101 && loaded.size() == 101);
+        loaded.read("tree (1)", [&](auto const &tree)
+        {
+            total = tree.Value("key");
+        });
+        assert(total == 10);
+        loaded.read("back\\slash\\)\nname", [&](auto const &tree)
+        {
+            total = tree.Value("line\nbreak");
+        });
+        assert(total == 7);
+        for (auto damaged : {"tree 1 1 [(key,1),null,null]\n"s, "9 (tree 1) 1 [(key,1),null,null]\n"s,
+                             "33 (tree (1\\)) 1 [(key,0),null,null]\n29 (tree 2) 1 [(key,0),null,null\n"s})
+        {
+            std::istringstream broken(damaged);
+            bool malformed = false;
+            try
+            {
+                loaded.load(broken);
+            }
+            catch (decltype(loaded)::record_malformed const &)
+            {
+                malformed = true;
+            }
+            assert(malformed && loaded.size() == 101);
+        }
+        loaded.read("tree (1)", [&](auto const &tree)
+        {
+            total = tree.Value("key");
+        });
+        assert(total == 10);
+    }
+    {
+        std::string text;
+        for (int i = 0; i < 5000; ++i)
+            text += "(key " + std::to_string(i % 97) + ",value),null,";
+        text += std::string(300, 'x') + "abc";
+        for (auto size : {std::size_t(7), std::size_t(1000), text.size()})
+        {
+            std::stringstream stream;
+            {
+                snapshot_writer writer(stream, size);
+                std::ostream(&writer) << text;
+            }
+            assert(read_snapshot(stream, 4) == text);
+        }
+
+        tree_adapter<std::string, std::string> big;
+        std::string big_definition = "[";
+        for (int i = 0; i < 2000; ++i)
+            big_definition += "(key " + std::to_string(i) + ",value " + std::to_string(i % 10) + "),null,";
+        big.CreateBiTree(big_definition + "null]");
+        std::stringstream saved;
+        auto[raw, stored] = save_snapshot(saved, big, 4096);
+        assert(stored * 3 < raw);
+        decltype(big) restored;
+        load_snapshot(saved, restored);
+        assert(restored == big);
+        std::stringstream fragmented;
+        save_snapshot(fragmented, big, 7);
+        decltype(big) reassembled;
+        load_snapshot(fragmented, reassembled, 3);
+        assert(reassembled == big);
+
+        std::istringstream truncated(saved.str().substr(0, saved.str().size() - 10));
+        bool rejected = false;
+        try
+        {
+            load_snapshot(truncated, restored);
+        }
+        catch (snapshot_corrupt const &)
+        {
+            rejected = true;
+        }
+        assert(rejected && restored == big);
+
+        std::istringstream oversized("DSXC\xff\xff\xff\x7f"s);
+        rejected = false;
+        try
+        {
+            read_snapshot(oversized);
+        }
+        catch (snapshot_corrupt const &)
+        {
+            rejected = true;
+        }
+        assert(rejected);
+
+        auto corrupt = saved.str();
+        for (auto offset : {std::size_t(20), corrupt.size() / 2, corrupt.size() - 8})
+        {
+            auto damaged = corrupt;
+            damaged[offset] ^= 0x20;
+            std::istringstream stream(damaged);
+            rejected = false;
+            try
+            {
+                read_snapshot(stream);
+            }
+            catch (snapshot_corrupt const &)
+            {
+                rejected = true;
+            }
+            assert(rejected);
+        }
+        assert(crc32c("123456789") == 0xe3069283u && crc32c("") == 0);
+        assert(crc32c("56789", crc32c("1234")) == crc32c("123456789"));
+        assert(checksum::detail::crc32c_software(~0u, reinterpret_cast<unsigned char const *>(corrupt.data()), corrupt.size()) ==
+               ~crc32c(corrupt));
+    }
+    {
+        for (auto shape : {workload_shape::uniform, workload_shape::zipf, workload_shape::insert_heavy,
+                           workload_shape::deep_chain})
+        {
+            std::stringstream trace;
+            auto written = generate_trace(trace, shape, 500, 64);
+            assert(written == 501);
+            tree_adapter<int> replayed;
+            auto report = replay_trace(trace, replayed);
+            assert(report.records == 501 && report.failures == 0);
+            auto &value = report.operations[static_cast<std::size_t>(operation::Value)];
+            assert(value.calls > 0 && value.p50 <= value.p99 && value.p99 <= value.max);
+            if (shape == workload_shape::insert_heavy)
+                assert(replayed.BiTreeDepth() > 7);
+        }
+
+        std::stringstream trace;
+        trace_writer writer(trace);
+        writer.write({operation::CreateBiTree, 5, {"[(a),(b),null,null,(c),null,null]"}});
+        writer.write({operation::Child, 9, {"a", "right"}});
+        writer.write({operation::Value, 12, {"missing"}});
+        trace_reader reader(trace);
+        trace_record record;
+        bool read = reader.next(record);
+        assert(read && record.op == operation::CreateBiTree && record.nanoseconds == 5);
+        read = reader.next(record);
+        assert(read && record.nanoseconds == 9 && record.arguments.back() == "right");
+        read = reader.next(record);
+        assert(read);
+        read = reader.next(record);
+        assert(!read);
+        trace.clear();
+        trace.seekg(0);
+        tree_adapter<std::string> replayed;
+        auto report = replay_trace(trace, replayed);
+        assert(report.records == 3 && report.failures == 1);
+
+        for (auto damaged : {"DSTR\x01\x00\xff\xff\xff\xff\x0f"s, "DSTR\x01\x00\x01\xff\xff\xff\xff\x0f"s})
+        {
+            std::istringstream damaged_trace(damaged);
+            trace_reader damaged_reader(damaged_trace);
+            bool rejected = false;
+            try
+            {
+                damaged_reader.next(record);
+            }
+            catch (trace_corrupt const &)
+            {
+                rejected = true;
+            }
+            assert(rejected);
+        }
+    }
+#ifdef DS_EXP_RECORD
+    {
+        std::stringstream trace;
+        trace_recorder recorder(trace);
+        decltype(adapter) recorded;
+        {
+            scoped_recording recording(recorder);
+            recorded.CreateBiTree(definition);
+            recorded.Assign("left left", 30);
+            recorded.Child("left", right_child);
+            recorded.DeleteChild(recorded.get_iterator("left"), left_child);
+        }
+        recorded.Value("left");
+        assert(recorder.size() == 4);
+        decltype(adapter) replayed;
+        auto report = replay_trace(trace, replayed);
+        assert(report.records == 4 && report.failures == 0 && replayed == recorded);
+    }
+#endif
+#ifdef DS_EXP_INSTRUMENT
+    {
+        auto live = heap_snapshot().live_bytes();
+        reset_statistics();
+        assert(heap_snapshot().allocations == 0 && heap_snapshot().live_bytes() == live);
+        decltype(adapter) traced;
+        traced.CreateBiTree(definition);
+        assert(heap_snapshot().allocations == 5 && heap_snapshot().allocated_bytes == 5 * sizeof(decltype(traced)::tree_type::node_type));
+        assert(traced.Value("left left") == 3);
+        bool missed = false;
+        try
+        {
+            traced.Assign("missing", 0);
+        }
+        catch (decltype(adapter)::precondition_failed_to_satisfy const &)
+        {
+            missed = true;
+        }
+        assert(missed);
+        auto stats = snapshot();
+        auto &create = stats[static_cast<std::size_t>(operation::CreateBiTree)];
+        auto &value = stats[static_cast<std::size_t>(operation::Value)];
+        auto &assign = stats[static_cast<std::size_t>(operation::Assign)];
+        assert(create.calls == 1 && create.allocations == 5);
+        assert(value.calls == 1 && value.nodes_visited == 3);
+        assert(assign.calls == 1 && assign.nodes_visited == 5);
+        std::ostringstream json;
+        dump_json(json, stats);
+        assert(json.str().find("\"Value\":{\"calls\":1,") != std::string::npos);
+    }
+#endif
 }
@@ -0,0 +1,57 @@
+#include <string>
+#include <vector>
+#include "test_tree_export.hpp"
+#include "../tree_export.hpp"
+
+namespace
+{
+    template <typename order_t>
+    void check_export(ds_exp::binary_tree<int> const &tree, order_t order)
+    {
+        using namespace ds_exp;
+        std::vector<int> expected(tree.begin(order), tree.end(order));
+        assert(export_values(tree, order) == expected);
+
+        auto size = tree.size();
+        std::vector<int> values(size), parallel_values(size);
+        std::vector<std::size_t> depths(size), parents(size), parallel_depths(size), parallel_parents(size);
+        std::vector<node<int> const *> nodes(size);
+        export_buffers<int> out{values.data(), nodes.data(), depths.data(), parents.data()};
+        assert(export_traversal(tree, out, order) == size);
+        assert(values == expected);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            assert(nodes[i]->value == values[i]);
+            if (parents[i] == no_parent)
+                assert(nodes[i] == tree.root_node() && depths[i] == 0);
+            else
+                assert(nodes[parents[i]] == nodes[i]->parent && depths[parents[i]] + 1 == depths[i]);
+        }
+        export_buffers<int> parallel_out{parallel_values.data(), nullptr, parallel_depths.data(), parallel_parents.data()};
+        assert(parallel_export_traversal(tree, parallel_out, order, left_first, 3) == size);
+        assert(parallel_values == values && parallel_depths == depths && parallel_parents == parents);
+    }
+}
+
+void test_tree_export()
+{
+    using namespace ds_exp;
+    std::vector<int> sorted;
+    for (int i = 0; i < 1000; ++i)
+        sorted.push_back(i);
+    auto tree = binary_tree<int>::from_sorted(sorted.begin(), sorted.end());
+    tree.replace_child(tree.begin(inorder), binary_tree<int>::from_sorted(sorted.begin(), sorted.begin() + 37), left_child);
+    check_export(tree, preorder);
+    check_export(tree, inorder);
+    check_export(tree, postorder);
+    assert(export_values(tree, inorder) != sorted);
+
+    auto levels = export_values(tree, level_order);
+    assert(levels.size() == tree.size() && levels.front() == *tree.root());
+    std::vector<std::size_t> depths(levels.size());
+    export_buffers<int> out;
+    out.depths = depths.data();
+    export_traversal(tree, out, level_order);
+    assert(std::is_sorted(depths.begin(), depths.end()) && depths.back() + 1 == tree.depth());
+    assert(export_values(binary_tree<int>{}, preorder).empty());
+}
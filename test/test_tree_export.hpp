@@ -0,0 +1,5 @@
+#ifndef INC_201703_TEST_TREE_EXPORT_HPP
+#define INC_201703_TEST_TREE_EXPORT_HPP
+
+void test_tree_export();
+#endif //INC_201703_TEST_TREE_EXPORT_HPP
@@ -1,9 +1,33 @@
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 #include "test_tree_parse.hpp"
 #include "../tree_parse.hpp"
 #include "../tree_adapter.hpp"
+#include "../parallel_parse.hpp"
+
+namespace
+{
+    struct point
+    {
+        int x = 0;
+        int y = 0;
+    };
+}
+namespace ds_exp
+{
+    template <>
+    struct element_parser<point>
+    {
+        static void parse(std::string_view str, point &p)
+        {
+            auto colon = str.find(':');
+            element_parser<int>::parse(str.substr(0, colon), p.x);
+            element_parser<int>::parse(str.substr(colon + 1), p.y);
+        }
+    };
+}
 
 void test_tree_parse()
 {
@@ -32,4 +56,112 @@ void test_tree_parse()
     decltype(tree) new_tree;
     new_istream >> new_tree;
     assert(tree == new_tree);
-}
\ No newline at end of file
+    {
+        using stored = adapter::detail::stored_t<std::string, int>;
+        for (std::size_t chunk = 1; chunk <= output.size(); chunk += 3)
+        {
+            tree_stream_parse<left_first_t, stored> stream_parse;
+            std::size_t consumed = 0;
+            for (std::size_t pos = 0; pos < output.size(); pos += chunk)
+                consumed += stream_parse.feed(std::string_view(output).substr(pos, chunk));
+            assert(consumed == output.size());
+            assert(stream_parse.get_binary_tree().value() == tree);
+        }
+        std::string definition = R"~([(root, 1), (left, 2), (left left, 3), null, null, null, (right, 4), null, (right right, 5), null,null] trailing)~";
+        std::istringstream definition_stream(definition);
+        auto expected = tree_parse<left_first_t, stored>(definition_stream).get_binary_tree().value();
+        tree_stream_parse<left_first_t, stored> stream_parse;
+        auto consumed = stream_parse.feed(definition);
+        assert(stream_parse.done() && definition.substr(consumed) == " trailing");
+        assert(stream_parse.get_binary_tree().value() == expected);
+
+        tree_stream_parse<left_first_t, int> bare_parse;
+        bare_parse.feed("[1, 2, null, nu");
+        assert(!bare_parse.done());
+        bare_parse.feed("ll, 3,null ,null]");
+        auto bare_tree = bare_parse.get_binary_tree().value();
+        assert(*bare_tree.root() == 1 && *bare_tree.root().first_child() == 2 && *bare_tree.root().second_child() == 3);
+        std::string padded = "[(a), b , null, null, null]";
+        std::istringstream padded_stream(padded);
+        tree_stream_parse<left_first_t, std::string> padded_parse;
+        padded_parse.feed(padded);
+        auto padded_tree = padded_parse.get_binary_tree().value();
+        auto padded_expected = tree_parse<left_first_t, std::string>(padded_stream).get_binary_tree().value();
+        assert(std::equal(padded_tree.begin(), padded_tree.end(), padded_expected.begin(), padded_expected.end()));
+        assert(*padded_tree.root().first_child() == "b ");
+        tree_stream_parse<left_first_t, int> empty_parse;
+        empty_parse.feed(" [ null ] ");
+        assert(!empty_parse.get_binary_tree());
+    }
+    {
+        using stored = adapter::detail::stored_t<std::string, int>;
+        std::ostringstream large;
+        large << "[";
+        for (int i = 0; i < 2000; ++i)
+            large << "(key\\) " << i << ", " << i << "),";
+        for (int i = 0; i < 200; ++i)
+            large << " bare " << i << "\\, " << i << ",";
+        for (int i = 0; i < 2200; ++i)
+            large << " null,";
+        large << "null]";
+        auto text = large.str();
+        std::istringstream text_stream(text);
+        auto expected = tree_parse<left_first_t, stored>(text_stream).get_binary_tree().value();
+        for (std::size_t chunk : {std::size_t(7), std::size_t(64), std::size_t(4096), text.size()})
+        {
+            auto parsed = parallel_tree_parse<left_first_t, stored>(text, 4, chunk).get_binary_tree().value();
+            assert(parsed == expected);
+            assert(std::equal(parsed.begin(), parsed.end(), expected.begin(), [](auto &lhs, auto &rhs)
+            {
+                return lhs.key == rhs.key && lhs.value == rhs.value;
+            }));
+        }
+        auto right_parsed = parallel_tree_parse<right_first_t, stored>(output, 2, 5).get_binary_tree().value();
+        std::istringstream right_stream(output);
+        assert((right_parsed == tree_parse<right_first_t, stored>(right_stream).get_binary_tree().value()));
+        assert((!parallel_tree_parse<left_first_t, int>(" [ null ] ").get_binary_tree()));
+        bool failed = false;
+        try
+        {
+            parallel_tree_parse<left_first_t, int>("[1, 2, null]", 2, 3).get_binary_tree();
+        }
+        catch (expect_failed const &)
+        {
+            failed = true;
+        }
+        assert(failed);
+    }
+    {
+        int integer = 0;
+        double floating = 0;
+        unsigned short small = 0;
+        char character = 0;
+        assign_element(" -42 ", integer);
+        assign_element("2.5e3", floating);
+        assign_element("+7", small);
+        assign_element("x", character);
+        assert(integer == -42 && floating == 2500 && small == 7 && character == 'x');
+        assign_element("13abc", integer);
+        assert(integer == 13);
+        bool failed = false;
+        try
+        {
+            assign_element("abc", integer);
+        }
+        catch (parse_failed const &)
+        {
+            failed = true;
+        }
+        assert(failed);
+        point p;
+        assign_element("3:4", p);
+        assert(p.x == 3 && p.y == 4);
+
+        adapter::detail::stored_t<std::string, std::string> element{"a,b\\", "c,d"};
+        std::ostringstream element_out;
+        element_out << element;
+        decltype(element) element_in;
+        adapter::detail::assign_element(element_out.str(), element_in);
+        assert(element_in.key == element.key && element_in.value == element.value);
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef INC_201703_TEST_UTILITY_HPP
+#define INC_201703_TEST_UTILITY_HPP
+
+#include <utility>
+
+template <typename Exception, typename Callable>
+bool throws(Callable &&callable)
+{
+    try
+    {
+        std::forward<Callable>(callable)();
+    }
+    catch (Exception const &)
+    {
+        return true;
+    }
+    return false;
+}
+#endif //INC_201703_TEST_UTILITY_HPP
@@ -9,12 +9,22 @@
 #include "binary_tree.hpp"
 #include "tree_parse.hpp"
 #include "save_load.hpp"
+#include "instrumentation.hpp"
+#include "operation_trace.hpp"
+#include "memory_usage.hpp"
+#include "resumable_traversal.hpp"
+#include "lca_index.hpp"
+#include "subtree_index.hpp"
+#include "compaction.hpp"
+#include "key_fingerprint.hpp"
 
 namespace ds_exp
 {
     inline namespace adapter
     {
         class null_value_tag;
+        template <typename T>
+        class key_scan;
         namespace detail
         {
             template <typename Key, typename Value>
@@ -101,6 +111,25 @@ namespace ds_exp
                 return get_value(s.value);
             }
 
+            template <typename K>
+            decltype(auto) lookup_key(K const &key)
+            {
+                if constexpr (std::is_array_v<K> || std::is_pointer_v<K>)
+                    return std::basic_string_view<std::remove_cv_t<std::remove_pointer_t<std::decay_t<K>>>>(key);
+                else
+                    return (key);
+            }
+
+            template <typename Key, typename K, typename = void>
+            struct resolves_lookup : std::false_type
+            {
+            };
+            template <typename Key, typename K>
+            struct resolves_lookup<Key, K, std::void_t<decltype(Key::resolve(lookup_key(std::declval<K const &>())))>>
+                : std::true_type
+            {
+            };
+
             template <typename Key, typename Value>
             struct value_traits
             {
@@ -116,19 +145,96 @@ namespace ds_exp
                 using value_type = Key;
             };
             template <typename Key, typename Value>
+            void account_value(memory_usage &usage, stored_t<Key, Value> const &s)
+            {
+                using ds_exp::account_value;
+                account_value(usage, s.key);
+                account_value(usage, s.value);
+            }
+            constexpr char const *trace_name(left_first_t)
+            {
+                return "left";
+            }
+            constexpr char const *trace_name(right_first_t)
+            {
+                return "right";
+            }
+            constexpr char const *trace_name(preorder_t)
+            {
+                return "pre";
+            }
+            constexpr char const *trace_name(inorder_t)
+            {
+                return "in";
+            }
+            constexpr char const *trace_name(postorder_t)
+            {
+                return "post";
+            }
+
+            template <typename T>
+            std::string trace_definition(binary_tree<T> const &tree)
+            {
+                if constexpr (!instrument::detail::streamable<T>::value)
+                    return {};
+                else
+                {
+                    std::ostringstream stream;
+                    stream << tree;
+                    return stream.str();
+                }
+            }
+
+            inline void split_element(std::string str, std::string &key_input, std::string &value_input)
+            {
+                if (str.find('\\') == std::string::npos)
+                {
+                    auto comma = str.find(',');
+                    if (comma == std::string::npos)
+                        throw parse::expect_failed(",");
+                    value_input.assign(str, comma + 1);
+                    str.resize(comma);
+                    key_input = std::move(str);
+                } else
+                {
+                    auto current = &key_input;
+                    for (std::size_t pos = 0; pos < str.size(); ++pos)
+                    {
+                        if (str[pos] == '\\' && pos + 1 < str.size() && (str[pos + 1] == '\\' || str[pos + 1] == ','))
+                            ++pos;
+                        else if (str[pos] == ',' && current == &key_input)
+                        {
+                            current = &value_input;
+                            continue;
+                        }
+                        current->push_back(str[pos]);
+                    }
+                    if (current == &key_input)
+                        throw parse::expect_failed(",");
+                }
+            }
+            template <typename Key, typename Value>
             void assign_element(std::string str, detail::stored_t<Key, Value> &v)
             {
                 using ds_exp::assign_element;
-                std::istringstream source(str);
-                auto key_input = parse::detail::read_until(source, true, ',');
-                parse::detail::force_read_char(source, ',');
-                auto value_input = parse::detail::read_until(source, true);
+                std::string key_input, value_input;
+                split_element(std::move(str), key_input, value_input);
                 assign_element(std::move(key_input), v.key);
                 assign_element(std::move(value_input), v.value);
             }
+            template <typename Key, typename Value>
+            void assign_element(std::string str, detail::stored_t<Key, Value> &v, std::ios_base &source)
+            {
+                using ds_exp::assign_element;
+                std::string key_input, value_input;
+                split_element(std::move(str), key_input, value_input);
+                assign_element(std::move(key_input), v.key, source);
+                assign_element(std::move(value_input), v.value, source);
+            }
         }
         using detail::get_key;
         using detail::get_value;
+        using detail::lookup_key;
         using detail::value_traits;
 
         using namespace std::literals;
@@ -144,10 +250,65 @@ namespace ds_exp
 
         private:
             std::optional<tree_type> tree;
+            mutable fingerprint_cache<element_type> fingerprints;
 
             tree_adapter(tree_type &&tree)
                 :tree(std::move(tree))
             {}
+            template <typename Tree, typename K, typename order_t, typename dir_t>
+            static auto find_key(Tree &tree, K const &key, order_t order, dir_t dir)
+            {
+                if constexpr (!std::is_same_v<K, key_type> && detail::resolves_lookup<key_type, K>::value)
+                {
+                    auto resolved = key_type::resolve(lookup_key(key));
+                    if (!resolved)
+                        return tree.end(order, dir);
+                    return find_key(tree, *resolved, order, dir);
+                } else
+                    return std::find_if(tree.begin(order, dir), tree.end(order, dir), [&](auto const &element)
+                    {
+                        DS_EXP_TRACE_VISIT();
+                        if constexpr (std::is_same_v<K, key_type>)
+                            return element == key;
+                        else
+                            return get_key(element) == lookup_key(key);
+                    });
+            }
+            template <typename Tree, typename K, typename order_t, typename dir_t>
+            auto locate(Tree &target, K const &key, order_t order, dir_t dir) const
+            {
+                using stored_key = std::decay_t<decltype(get_key(std::declval<element_type const &>()))>;
+                using lookup_type = std::decay_t<decltype(lookup_key(key))>;
+                if constexpr (!std::is_same_v<K, key_type> && detail::resolves_lookup<key_type, K>::value)
+                {
+                    auto resolved = key_type::resolve(lookup_key(key));
+                    if (!resolved)
+                        return target.end(order, dir);
+                    return locate(target, *resolved, order, dir);
+                } else
+                {
+                    if constexpr (std::is_same_v<order_t, preorder_t> && std::is_same_v<dir_t, left_first_t> &&
+                                  detail::fingerprintable<stored_key> &&
+                                  (std::is_same_v<lookup_type, stored_key> ||
+                                   (std::is_convertible_v<lookup_type const &, std::string_view> &&
+                                    std::is_convertible_v<stored_key const &, std::string_view>)))
+                    {
+                        auto &&lookup = lookup_key(key);
+                        typename tree_type::node_type const *found;
+                        if (fingerprints.find(target, detail::key_fingerprint(lookup),
+                                              [](element_type const &element) -> decltype(auto)
+                                              {
+                                                  return get_key(element);
+                                              },
+                                              [&](element_type const &element)
+                                              {
+                                                  return get_key(element) == lookup;
+                                              }, found))
+                            return found ? target.position(found, order, dir) : target.end(order, dir);
+                    }
+                    return find_key(target, key, order, dir);
+                }
+            }
         public:
             struct tree_exists : std::logic_error
             {
@@ -170,13 +331,7 @@ namespace ds_exp
                 {
                 }
             };
-            struct precondition_failed_to_satisfy : std::logic_error
-            {
-                precondition_failed_to_satisfy(std::string const &function)
-                    : logic_error("The precondition of funciton "s + function + " failed to satisfy.")
-                {
-                }
-            };
+            using precondition_failed_to_satisfy = ds_exp::precondition_failed_to_satisfy;
 
             tree_adapter() = default;
             void InitBiTree()
@@ -190,13 +345,16 @@ namespace ds_exp
                 if (!tree)
                     throw tree_not_exist(__func__);
                 tree.reset();
+                fingerprints.clear();
             }
             void CreateBiTree(std::istream &definition)
             {
+                DS_EXP_TRACE_OPERATION(CreateBiTree);
                 auto generated_tree = tree_parse<left_first_t, element_type>(definition).get_binary_tree();
                 if (!generated_tree)
                     throw parse_failed(__func__);
-                tree = generated_tree;
+                tree = std::move(generated_tree);
+                DS_EXP_RECORD_CALL(CreateBiTree, detail::trace_definition(*tree));
             }
             void CreateBiTree(std::string const &string)
             {
@@ -227,89 +385,178 @@ namespace ds_exp
                     throw tree_not_exist(__func__);
                 return tree->root();
             }
-            template <typename order_t = preorder_t, typename dir_t = left_first_t>
-            auto &Value(key_type const &key, order_t order = order_t{}, dir_t dir = dir_t{}) const
+            template <typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            auto TryValue(K const &key, order_t order = order_t{}, dir_t dir = dir_t{}) const
             {
+                DS_EXP_TRACE_OPERATION(Value);
+                DS_EXP_RECORD_CALL(Value, key);
                 if (!tree)
                     throw tree_not_exist(__func__);
-                for (auto &element : tree_iterate(*tree, order, dir))
-                    if(element == key)
-                        return get_value(element);
+                auto iter = locate(*tree, key, order, dir);
+                return iter ? &get_value(*iter) : nullptr;
+            }
+            template <typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            auto &Value(K const &key, order_t order = order_t{}, dir_t dir = dir_t{}) const
+            {
+                if (auto value = TryValue(key, order, dir))
+                    return *value;
                 throw precondition_failed_to_satisfy(__func__);
             }
-            template <typename U, typename order_t = preorder_t, typename dir_t = left_first_t>
-            void Assign(key_type const &key, U &&value, order_t order = order_t{}, dir_t dir = dir_t{})
+            template <typename U, typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            bool TryAssign(K const &key, U &&value, order_t order = order_t{}, dir_t dir = dir_t{})
             {
+                DS_EXP_TRACE_OPERATION(Assign);
+                DS_EXP_RECORD_CALL(Assign, key, value);
                 if (!tree)
                     throw tree_not_exist(__func__);
-                if (auto iter = std::find(tree->begin(order, dir), tree->end(order, dir), key))
+                auto iter = locate(*tree, key, order, dir);
+                if (iter)
+                {
                     get_value(*iter) = std::forward<U>(value);
-                else
+                    if constexpr (std::is_same_v<element_type, key_type>)
+                        fingerprints.clear();
+                }
+                return static_cast<bool>(iter);
+            }
+            template <typename U, typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            void Assign(K const &key, U &&value, order_t order = order_t{}, dir_t dir = dir_t{})
+            {
+                if (!TryAssign(key, std::forward<U>(value), order, dir))
                     throw precondition_failed_to_satisfy(__func__);
             }
 
-            template <typename order_t = preorder_t, typename dir_t = left_first_t>
-            auto Parent(key_type const &key, order_t order = order_t{}, dir_t dir = dir_t{}) const
+            template <typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            auto TryParent(K const &key, order_t order = order_t{}, dir_t dir = dir_t{}) const
             {
+                DS_EXP_TRACE_OPERATION(Parent);
+                DS_EXP_RECORD_CALL(Parent, key);
                 if (!tree)
                     throw tree_not_exist(__func__);
-                if (auto iter = std::find(tree->begin(order, dir), tree->end(order, dir), key))
-                    return iter.parent();
+                auto iter = locate(*tree, key, order, dir);
+                return iter ? std::optional(iter.parent()) : std::nullopt;
+            }
+            template <typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            auto Parent(K const &key, order_t order = order_t{}, dir_t dir = dir_t{}) const
+            {
+                if (auto parent = TryParent(key, order, dir))
+                    return *parent;
                 throw precondition_failed_to_satisfy(__func__);
             }
-            template <typename child_t, typename order_t = preorder_t, typename dir_t = left_first_t>
-            auto Child(key_type const &key, child_t child = child_t{}, order_t order = order_t{}, dir_t dir = dir_t{}) const
+            template <typename child_t, typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            auto TryChild(K const &key, child_t child = child_t{}, order_t order = order_t{}, dir_t dir = dir_t{}) const
             {
+                DS_EXP_TRACE_OPERATION(Child);
+                DS_EXP_RECORD_CALL(Child, key, detail::trace_name(child));
                 if (!tree)
                     throw tree_not_exist(__func__);
-                if (auto iter = std::find(tree->begin(order, dir), tree->end(order, dir), key))
-                    return iter.first_child(child);
+                auto iter = locate(*tree, key, order, dir);
+                return iter ? std::optional(iter.first_child(child)) : std::nullopt;
+            }
+            template <typename child_t, typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            auto Child(K const &key, child_t child = child_t{}, order_t order = order_t{}, dir_t dir = dir_t{}) const
+            {
+                if (auto found = TryChild(key, child, order, dir))
+                    return *found;
                 throw precondition_failed_to_satisfy(__func__);
             }
-            template <typename child_t, typename order_t = preorder_t, typename dir_t = left_first_t>
-            auto Sibling(key_type const &key, child_t child = child_t{}, order_t order = order_t{}, dir_t dir = dir_t{}) const
+            template <typename child_t, typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            auto TrySibling(K const &key, child_t child = child_t{}, order_t order = order_t{}, dir_t dir = dir_t{}) const
             {
+                DS_EXP_TRACE_OPERATION(Sibling);
+                DS_EXP_RECORD_CALL(Sibling, key, detail::trace_name(child));
                 if (!tree)
                     throw tree_not_exist(__func__);
-                if (auto iter = std::find(tree->begin(order, dir), tree->end(order, dir), key))
-                {
-                    auto desired_child = iter.parent().first_child(child);
-                    if (desired_child == iter)
-                        return tree->end(order, dir);
-                    return desired_child;
-                }
+                auto iter = locate(*tree, key, order, dir);
+                if (!iter)
+                    return std::optional<decltype(iter)>();
+                auto desired_child = iter.parent().first_child(child);
+                if (desired_child == iter)
+                    return std::optional(tree->end(order, dir));
+                return std::optional(desired_child);
+            }
+            template <typename child_t, typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            auto Sibling(K const &key, child_t child = child_t{}, order_t order = order_t{}, dir_t dir = dir_t{}) const
+            {
+                if (auto sibling = TrySibling(key, child, order, dir))
+                    return *sibling;
                 throw precondition_failed_to_satisfy(__func__);
             }
             template <typename child_t, typename iter, typename dir_t = right_t>
             void InsertChild(iter pos, tree_adapter inserted, child_t child = child_t{}, dir_t dir = dir_t{})
             {
+                DS_EXP_TRACE_OPERATION(InsertChild);
                 if (!tree)
                     throw tree_not_exist(__func__);
+                DS_EXP_RECORD_CALL(InsertChild, get_key(*pos), detail::trace_name(child),
+                                   detail::trace_definition(inserted.tree.value()), detail::trace_name(dir));
                 auto replaced = tree->replace_child(pos, std::move(inserted.tree.value()), child);
                 auto farest = tree->begin(inorder, dir);
                 auto empty = tree->replace_child(farest, std::move(replaced), dir);
                 assert(empty.empty());
             }
+            template <typename child_t, typename iter, typename attach_iter, typename dir_t>
+            void InsertChild(iter pos, tree_adapter inserted, child_t child, attach_iter attach, dir_t dir)
+            {
+                DS_EXP_TRACE_OPERATION(InsertChild);
+                if (!tree || !inserted.tree)
+                    throw tree_not_exist(__func__);
+                DS_EXP_RECORD_CALL(InsertChild, get_key(*pos), detail::trace_name(child),
+                                   detail::trace_definition(*inserted.tree), get_key(*attach), detail::trace_name(dir));
+                tree->splice(pos, std::move(inserted.tree.value()), child, attach, dir);
+            }
             template <typename child_t, typename iter>
             auto DeleteChild(iter pos, child_t child = child_t{})
             {
+                DS_EXP_TRACE_OPERATION(DeleteChild);
                 if (!tree)
                     throw tree_not_exist(__func__);
+                DS_EXP_RECORD_CALL(DeleteChild, get_key(*pos), detail::trace_name(child));
                 return tree_adapter(tree->replace_child(pos, tree_type{}, child));
             }
             template <typename Callable, typename order_t, typename dir_t = left_first_t>
             void Traverse(Callable callable, order_t order, dir_t dir = dir_t{})
             {
+                DS_EXP_TRACE_OPERATION(Traverse);
                 if (!tree)
                     throw tree_not_exist(__func__);
+                DS_EXP_RECORD_CALL(Traverse, detail::trace_name(order), detail::trace_name(dir));
+                fingerprints.clear();
                 for(auto &element : tree_iterate(*tree, order, dir))
+                {
+                    DS_EXP_TRACE_VISIT();
                     callable(element);
+                }
+            }
+            template <typename order_t, typename dir_t = left_first_t>
+            auto ResumableTraverse(order_t order, dir_t dir = dir_t{})
+            {
+                if (!tree)
+                    throw tree_not_exist(__func__);
+                fingerprints.clear();
+                return make_resumable_traversal(*tree, order, dir);
+            }
+            template <typename order_t = preorder_t, typename dir_t = left_first_t>
+            auto Compact(order_t order = order_t{}, dir_t dir = dir_t{}, bool track = false)
+            {
+                if (!tree)
+                    throw tree_not_exist(__func__);
+                return compact(*tree, order, dir, track);
+            }
+            template <typename order_t = preorder_t, typename dir_t = left_first_t>
+            auto ResumableCompact(order_t order = order_t{}, dir_t dir = dir_t{}, bool track = false)
+            {
+                if (!tree)
+                    throw tree_not_exist(__func__);
+                return make_tree_compaction(*tree, order, dir, track);
             }
             template <typename Callable, typename dir_t = left_first_t>
             void LevelOrderTraverse(Callable callable, dir_t dir = dir_t{})
             {
+                DS_EXP_TRACE_OPERATION(LevelOrderTraverse);
                 if (!tree)
                     throw tree_not_exist(__func__);
+                DS_EXP_RECORD_CALL(LevelOrderTraverse, detail::trace_name(dir));
+                fingerprints.clear();
                 auto iter = tree->root(preorder, dir);
                 if(!iter)
                     return;
@@ -322,15 +569,25 @@ namespace ds_exp
                         queue.push(iter.first_child(dir));
                     if (iter.second_child(dir))
                         queue.push(iter.second_child(dir));
+                    DS_EXP_TRACE_VISIT();
                     callable(*iter);
                 }
             }
 
-            template <typename order_t = preorder_t, typename dir_t = left_first_t>
-            auto get_iterator(key_type const &key, order_t order = order_t{}, dir_t dir = dir_t{})
+            template <typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            auto try_get_iterator(K const &key, order_t order = order_t{}, dir_t dir = dir_t{})
+            {
+                if (!tree)
+                    throw tree_not_exist(__func__);
+                auto iter = locate(*tree, key, order, dir);
+                fingerprints.clear();
+                return iter ? std::optional(iter) : std::nullopt;
+            }
+            template <typename order_t = preorder_t, typename dir_t = left_first_t, typename K = key_type>
+            auto get_iterator(K const &key, order_t order = order_t{}, dir_t dir = dir_t{})
             {
-                if(auto iter = std::find(tree->begin(order, dir), tree->end(order, dir), key))
-                    return iter;
+                if(auto iter = try_get_iterator(key, order, dir))
+                    return *iter;
                 throw precondition_failed_to_satisfy(__func__);
             }
             template <typename order_t = preorder_t, typename dir_t = left_first_t>
@@ -338,9 +595,53 @@ namespace ds_exp
             {
                 if(!tree)
                     throw precondition_failed_to_satisfy(__func__);
+                fingerprints.clear();
                 return tree->end(order, dir);
             }
 
+            template <typename order_t = preorder_t, typename dir_t = left_first_t>
+            auto KeyScan(order_t order = order_t{}, dir_t dir = dir_t{}) const
+            {
+                if (!tree)
+                    throw tree_not_exist(__func__);
+                return key_scan<element_type>(*tree, order, dir);
+            }
+
+            auto AncestorIndex() const
+            {
+                if (!tree)
+                    throw tree_not_exist(__func__);
+                return lca_index<element_type>(*tree);
+            }
+
+            subtree_index SaveIndexed(std::ostream &out, std::size_t stride = 1) const
+            {
+                if (!tree)
+                    throw tree_not_exist(__func__);
+                out << 1 << " ";
+                return save_indexed(out, *tree, stride);
+            }
+            static tree_adapter LoadSubtree(std::istream &in, subtree_index const &index, std::size_t rank)
+            {
+                int has_tree = 0;
+                if (!(in >> has_tree) || !has_tree)
+                    throw tree_not_exist(__func__);
+                auto subtree = load_subtree<element_type>(in, index, rank);
+                if (!subtree)
+                    throw precondition_failed_to_satisfy(__func__);
+                return tree_adapter(std::move(*subtree));
+            }
+
+            memory_usage measure_memory() const
+            {
+                memory_usage usage;
+                if (tree)
+                    usage = tree::measure_memory(*tree);
+                usage.index_bytes = fingerprints.heap_bytes();
+                usage.container_bytes = sizeof(*this);
+                return usage;
+            }
+
             friend bool operator==(tree_adapter const &lhs, tree_adapter const &rhs)
             {
                 return *lhs.tree == *rhs.tree;
@@ -360,6 +661,7 @@ namespace ds_exp
             {
                 int has_tree = 0;
                 in >> has_tree;
+                tree.fingerprints.clear();
                 if(!has_tree)
                     tree.tree.reset();
                 else
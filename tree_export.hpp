@@ -0,0 +1,278 @@
+#ifndef INC_201703_TREE_EXPORT_HPP
+#define INC_201703_TREE_EXPORT_HPP
+
+#include <algorithm>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "binary_tree.hpp"
+#include "parallel.hpp"
+
+namespace ds_exp
+{
+    inline namespace tree
+    {
+        struct level_order_t
+        {
+            constexpr level_order_t() = default;
+            using inverse = level_order_t;
+        };
+        constexpr level_order_t level_order;
+
+        constexpr std::size_t no_parent = static_cast<std::size_t>(-1);
+
+        template <typename T>
+        struct export_buffers
+        {
+            T *values = nullptr;
+            node<T> const **nodes = nullptr;
+            std::size_t *depths = nullptr;
+            std::size_t *parents = nullptr;
+        };
+
+        namespace detail
+        {
+            template <typename T>
+            void export_node(export_buffers<T> const &out, std::size_t index, node<T> const *p, std::size_t depth,
+                             std::size_t parent)
+            {
+                if (out.values)
+                    out.values[index] = p->value;
+                if (out.nodes)
+                    out.nodes[index] = p;
+                if (out.depths)
+                    out.depths[index] = depth;
+                if (out.parents)
+                    out.parents[index] = parent;
+            }
+
+            template <typename order_t, typename dir_t, typename T>
+            std::size_t export_subtree(node<T> const *root, export_buffers<T> const &out, std::size_t index,
+                                       std::size_t depth, std::size_t parent)
+            {
+                using direction = iterate_direction<dir_t>;
+                struct frame
+                {
+                    node<T> const *p;
+                    std::size_t depth;
+                    std::size_t index;
+                    std::size_t pending[2];
+                    unsigned pending_count;
+                    unsigned state;
+                };
+                std::vector<frame> stack;
+                stack.reserve(64);
+                auto emit = [&](std::size_t k)
+                {
+                    auto &f = stack[k];
+                    f.index = index++;
+                    auto parent_index = parent;
+                    if (k > 0)
+                    {
+                        auto &above = stack[k - 1];
+                        parent_index = above.index;
+                        if (parent_index == no_parent)
+                            above.pending[above.pending_count++] = f.index;
+                    }
+                    export_node(out, f.index, f.p, f.depth, parent_index);
+                    if (out.parents)
+                        for (unsigned i = 0; i < f.pending_count; ++i)
+                            out.parents[f.pending[i]] = f.index;
+                };
+                stack.push_back(frame{root, depth, no_parent, {}, 0, 0});
+                while (!stack.empty())
+                {
+                    auto k = stack.size() - 1;
+                    auto current = stack[k].p;
+                    auto child_depth = stack[k].depth + 1;
+                    switch (stack[k].state++)
+                    {
+                        case 0:
+                            if constexpr (std::is_same_v<order_t, preorder_t>)
+                                emit(k);
+                            if (auto &child = direction::first_child(current))
+                                stack.push_back(frame{child.get(), child_depth, no_parent, {}, 0, 0});
+                            break;
+                        case 1:
+                            if constexpr (std::is_same_v<order_t, inorder_t>)
+                                emit(k);
+                            if (auto &child = direction::second_child(current))
+                                stack.push_back(frame{child.get(), child_depth, no_parent, {}, 0, 0});
+                            break;
+                        default:
+                            if constexpr (std::is_same_v<order_t, postorder_t>)
+                                emit(k);
+                            stack.pop_back();
+                    }
+                }
+                return index;
+            }
+
+            template <typename dir_t, typename T>
+            std::size_t export_level_order(node<T> const *root, export_buffers<T> const &out)
+            {
+                using direction = iterate_direction<dir_t>;
+                struct entry
+                {
+                    node<T> const *p;
+                    std::size_t depth;
+                    std::size_t parent;
+                };
+                std::vector<entry> queue;
+                queue.push_back(entry{root, 0, no_parent});
+                for (std::size_t head = 0; head < queue.size(); ++head)
+                {
+                    auto current = queue[head];
+                    export_node(out, head, current.p, current.depth, current.parent);
+                    if (auto &child = direction::first_child(current.p))
+                        queue.push_back(entry{child.get(), current.depth + 1, head});
+                    if (auto &child = direction::second_child(current.p))
+                        queue.push_back(entry{child.get(), current.depth + 1, head});
+                }
+                return queue.size();
+            }
+
+            template <typename order_t, typename dir_t, typename T>
+            class parallel_exporter
+            {
+                using node_type = node<T>;
+                using direction = iterate_direction<dir_t>;
+                struct task
+                {
+                    node_type const *root;
+                    std::size_t depth;
+                    std::size_t index;
+                    std::size_t parent;
+                };
+
+            public:
+                parallel_exporter(export_buffers<T> const &out, unsigned threads)
+                    : out(out), threads(std::max(threads, 1u))
+                {
+                    while ((std::size_t(1) << cut_depth) < std::size_t(this->threads) * 4)
+                        ++cut_depth;
+                }
+                std::size_t run(node_type const *root)
+                {
+                    collect(root, 0);
+                    std::vector<std::size_t> task_sizes(cut_roots.size());
+                    parallel_for(cut_roots.size(), threads, [&](std::size_t i)
+                    {
+                        task_sizes[i] = export_subtree<preorder_t, dir_t>(cut_roots[i], export_buffers<T>{}, 0, 0, no_parent);
+                    });
+                    for (std::size_t i = 0; i < cut_roots.size(); ++i)
+                        sizes[cut_roots[i]] = task_sizes[i];
+                    auto size = size_of(root, 0);
+                    place(root, 0, 0, no_parent);
+                    parallel_for(tasks.size(), threads, [&](std::size_t i)
+                    {
+                        auto &t = tasks[i];
+                        export_subtree<order_t, dir_t>(t.root, out, t.index, t.depth, t.parent);
+                    });
+                    return size;
+                }
+
+            private:
+                void collect(node_type const *p, std::size_t depth)
+                {
+                    if (!p)
+                        return;
+                    if (depth == cut_depth)
+                    {
+                        cut_roots.push_back(p);
+                        return;
+                    }
+                    collect(direction::first_child(p).get(), depth + 1);
+                    collect(direction::second_child(p).get(), depth + 1);
+                }
+                std::size_t size_of(node_type const *p, std::size_t depth)
+                {
+                    if (!p)
+                        return 0;
+                    if (depth == cut_depth)
+                        return sizes[p];
+                    return sizes[p] = 1 + size_of(direction::first_child(p).get(), depth + 1) +
+                                      size_of(direction::second_child(p).get(), depth + 1);
+                }
+                void place(node_type const *p, std::size_t depth, std::size_t offset, std::size_t parent)
+                {
+                    if (!p)
+                        return;
+                    if (depth == cut_depth)
+                    {
+                        tasks.push_back(task{p, depth, offset, parent});
+                        return;
+                    }
+                    auto first = direction::first_child(p).get(), second = direction::second_child(p).get();
+                    auto first_size = first ? sizes[first] : 0, second_size = second ? sizes[second] : 0;
+                    std::size_t index = offset, first_offset = offset, second_offset = offset;
+                    if constexpr (std::is_same_v<order_t, preorder_t>)
+                        first_offset = offset + 1, second_offset = first_offset + first_size;
+                    else if constexpr (std::is_same_v<order_t, inorder_t>)
+                        index = offset + first_size, second_offset = index + 1;
+                    else
+                        second_offset = offset + first_size, index = second_offset + second_size;
+                    export_node(out, index, p, depth, parent);
+                    place(first, depth + 1, first_offset, index);
+                    place(second, depth + 1, second_offset, index);
+                }
+
+                export_buffers<T> out;
+                unsigned threads;
+                std::size_t cut_depth = 0;
+                std::vector<node_type const *> cut_roots;
+                std::unordered_map<node_type const *, std::size_t> sizes;
+                std::vector<task> tasks;
+            };
+        }
+
+        template <typename T, typename order_t, typename dir_t = left_first_t>
+        std::size_t export_traversal(binary_tree<T> const &tree, export_buffers<T> const &out, order_t = order_t{},
+                                     dir_t = dir_t{})
+        {
+            auto root = tree.root_node();
+            if (!root)
+                return 0;
+            if constexpr (std::is_same_v<order_t, level_order_t>)
+                return detail::export_level_order<dir_t>(root, out);
+            else
+                return detail::export_subtree<order_t, dir_t>(root, out, 0, 0, no_parent);
+        }
+
+        template <typename T, typename order_t, typename dir_t = left_first_t>
+        std::size_t parallel_export_traversal(binary_tree<T> const &tree, export_buffers<T> const &out,
+                                              order_t order = order_t{}, dir_t dir = dir_t{},
+                                              unsigned threads = default_concurrency())
+        {
+            auto root = tree.root_node();
+            if (!root)
+                return 0;
+            if constexpr (std::is_same_v<order_t, level_order_t>)
+                return export_traversal(tree, out, order, dir);
+            else
+                return detail::parallel_exporter<order_t, dir_t, T>(out, threads).run(root);
+        }
+
+        template <typename T, typename order_t, typename dir_t = left_first_t>
+        std::vector<T> export_values(binary_tree<T> const &tree, order_t order = order_t{}, dir_t dir = dir_t{})
+        {
+            std::vector<T> values(tree.size());
+            export_buffers<T> out;
+            out.values = values.data();
+            export_traversal(tree, out, order, dir);
+            return values;
+        }
+        template <typename T, typename order_t, typename dir_t = left_first_t>
+        std::vector<node<T> const *> export_nodes(binary_tree<T> const &tree, order_t order = order_t{},
+                                                  dir_t dir = dir_t{})
+        {
+            std::vector<node<T> const *> nodes(tree.size());
+            export_buffers<T> out;
+            out.nodes = nodes.data();
+            export_traversal(tree, out, order, dir);
+            return nodes;
+        }
+    }
+}
+
+#endif //INC_201703_TREE_EXPORT_HPP
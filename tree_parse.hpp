@@ -2,11 +2,17 @@
 #ifndef INC_201703_TREE_PARSE_HPP
 #define INC_201703_TREE_PARSE_HPP
 
+#include <charconv>
+#include <exception>
 #include <optional>
 #include <string_view>
 #include <sstream>
 #include <stdexcept>
+#include <system_error>
+#include <type_traits>
 #include <functional>
+#include <utility>
+#include <vector>
 #include "binary_tree.hpp"
 
 namespace ds_exp
@@ -41,30 +47,86 @@ namespace ds_exp
             struct final_call
             {
                 final_call(U c)
-                    : call(c)
+                    : call(c), pending(std::uncaught_exceptions())
                 {
                 }
-                ~final_call()
+                ~final_call() noexcept(false)
                 {
-                    call();
+                    if (std::uncaught_exceptions() <= pending)
+                        call();
                 }
                 U call;
+                int pending;
             };
         }
 
+        namespace detail
+        {
+            template <typename T>
+            constexpr bool is_character_v = std::is_same_v<T, char> || std::is_same_v<T, signed char> ||
+                                            std::is_same_v<T, unsigned char> || std::is_same_v<T, wchar_t> ||
+                                            std::is_same_v<T, char16_t> || std::is_same_v<T, char32_t>;
+            template <typename T>
+            constexpr bool from_chars_convertible_v = (std::is_integral_v<T> && !std::is_same_v<T, bool> && !is_character_v<T>) ||
+                                                      std::is_floating_point_v<T>;
+
+            template <typename T>
+            void stream_assign(std::string_view str, T &v)
+            {
+                std::istringstream stream{std::string(str)};
+                stream >> v;
+                if (!stream)
+                    throw parse_failed();
+            }
+            inline bool is_blank(char c)
+            {
+                return std::isspace(static_cast<unsigned char>(c));
+            }
+        }
+
+        template <typename T, typename = void>
+        struct element_parser
+        {
+            static void parse(std::string_view str, T &v)
+            {
+                detail::stream_assign(str, v);
+            }
+        };
+        template <typename T>
+        struct element_parser<T, std::enable_if_t<detail::from_chars_convertible_v<T>>>
+        {
+            static void parse(std::string_view str, T &v)
+            {
+                auto first = str.data(), last = str.data() + str.size();
+                while (first != last && detail::is_blank(*first))
+                    ++first;
+                if (first != last && (std::isdigit(static_cast<unsigned char>(*first)) || *first == '-' || *first == '.'))
+                {
+                    auto[end, error] = std::from_chars(first, last, v);
+                    while (error == std::errc{} && end != last && detail::is_blank(*end))
+                        ++end;
+                    if (error == std::errc{} && end == last)
+                        return;
+                }
+                detail::stream_assign(str, v);
+            }
+        };
+
         template <typename value>
         void assign_element(std::string str, value &v)
         {
-            std::istringstream stream(str);
-            stream >> v;
-            if (!stream)
-                throw parse_failed();
+            element_parser<value>::parse(str, v);
         }
         template <>
         inline void assign_element(std::string str, std::string &v)
         {
             v = std::move(str);
         }
+        template <typename value>
+        void assign_element(std::string str, value &v, std::ios_base &)
+        {
+            assign_element(std::move(str), v);
+        }
 
         namespace detail
         {
@@ -152,12 +214,18 @@ namespace ds_exp
                 } else
                     return std::nullopt;
             }
+            std::optional<tree_type> get_preorder_subtree()
+            {
+                if (auto element = get_element())
+                    return get_subtree(std::move(element.value()));
+                return std::nullopt;
+            }
 
         private:
             tree_type get_subtree(value_type &&parent_element)
             {
                 tree_type tree;
-                tree.set_root(parent_element);
+                tree.set_root(std::move(parent_element));
                 fill_child<direction>(tree);
                 fill_child<typename direction::inverse>(tree);
                 return tree;
@@ -193,9 +261,174 @@ namespace ds_exp
                 } else
                     input = detail::read_until(source, false, ',', ']');
                 value_type result;
-                assign_element(std::move(input), result);
+                assign_element(std::move(input), result, source);
+                return result;
+            }
+        };
+
+        template <typename direction, typename T>
+        class tree_stream_parse
+        {
+            using tree_type = binary_tree<T>;
+            using value_type = typename tree_type::value_type;
+            using iterator = decltype(std::declval<tree_type &>().root());
+            enum class state
+            {
+                open, element, quoted, bare, separator, done
+            };
+            struct frame
+            {
+                iterator node;
+                bool first;
+            };
+
+        public:
+            std::size_t feed(std::string_view chunk)
+            {
+                std::size_t consumed = 0;
+                while (consumed < chunk.size() && current != state::done)
+                    consume(chunk[consumed++]);
+                return consumed;
+            }
+            bool done() const
+            {
+                return current == state::done;
+            }
+            std::optional<tree_type> get_binary_tree()
+            {
+                if (!done())
+                    throw unexpected_end();
+                if (!has_root)
+                    return std::nullopt;
+                return std::move(tree);
+            }
+
+        private:
+            void consume(char c)
+            {
+                bool space = std::isspace(static_cast<unsigned char>(c));
+                switch (current)
+                {
+                    case state::open:
+                        if (space)
+                            return;
+                        if (c != '[')
+                            throw expect_failed("[");
+                        current = state::element;
+                        return;
+                    case state::element:
+                        if (space)
+                            return;
+                        if (c == '(')
+                        {
+                            token.clear();
+                            current = state::quoted;
+                            return;
+                        }
+                        current = state::bare;
+                        [[fallthrough]];
+                    case state::bare:
+                        if (std::exchange(escaped, false))
+                        {
+                            if (c == ',' || c == ']')
+                                return token.push_back(c);
+                            token.push_back('\\');
+                        }
+                        if (c == '\\')
+                            escaped = true;
+                        else if (c == ',' || c == ']')
+                        {
+                            finish_bare();
+                            separate(c);
+                        } else
+                            token.push_back(c);
+                        return;
+                    case state::quoted:
+                        if (std::exchange(escaped, false))
+                        {
+                            if (c == ')')
+                                return token.push_back(c);
+                            token.push_back('\\');
+                        }
+                        if (c == '\\')
+                            escaped = true;
+                        else if (c == ')')
+                            attach(convert());
+                        else
+                            token.push_back(c);
+                        return;
+                    case state::separator:
+                        if (!space)
+                            separate(c);
+                        return;
+                    case state::done:
+                        return;
+                }
+            }
+            void separate(char c)
+            {
+                if (stack.empty() && started)
+                {
+                    if (c != ']')
+                        throw expect_failed("]");
+                    current = state::done;
+                    return;
+                }
+                if (c != ',')
+                    throw expect_failed(",");
+                token.clear();
+                current = state::element;
+            }
+            void finish_bare()
+            {
+                if (token.compare(0, 4, "null") == 0)
+                {
+                    if (token.find_first_not_of(" \t\n\v\f\r", 4) != std::string::npos)
+                        throw expect_failed(",");
+                    attach(std::nullopt);
+                } else
+                    attach(convert());
+            }
+            std::optional<value_type> convert()
+            {
+                value_type result;
+                assign_element(std::move(token), result);
+                token.clear();
                 return result;
             }
+            void attach(std::optional<value_type> element)
+            {
+                current = state::separator;
+                if (!std::exchange(started, true))
+                {
+                    if (element)
+                    {
+                        has_root = true;
+                        tree.set_root(std::move(*element));
+                        stack.push_back(frame{tree.root(), true});
+                    }
+                    return;
+                }
+                auto parent = stack.back().node;
+                bool first = stack.back().first;
+                if (first)
+                    stack.back().first = false;
+                else
+                    stack.pop_back();
+                if (!element)
+                    return;
+                auto child = first ? tree.new_child(parent, std::move(*element), direction{})
+                                   : tree.new_child(parent, std::move(*element), typename direction::inverse{});
+                stack.push_back(frame{child, true});
+            }
+
+            tree_type tree;
+            std::vector<frame> stack;
+            std::string token;
+            state current = state::open;
+            bool escaped = false;
+            bool started = false;
+            bool has_root = false;
         };
     }
 
@@ -0,0 +1,273 @@
+#ifndef INC_201703_TREE_STORE_HPP
+#define INC_201703_TREE_STORE_HPP
+
+#include <charconv>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "tree_adapter.hpp"
+#include "parallel.hpp"
+
+namespace ds_exp
+{
+    inline namespace store
+    {
+        template <typename Key, typename Value = null_value_tag>
+        class tree_store
+        {
+        public:
+            using adapter_type = tree_adapter<Key, Value>;
+            using name_type = std::string;
+
+            struct record_malformed : std::logic_error
+            {
+                explicit record_malformed(std::size_t record)
+                    : logic_error("Malformed tree store record " + std::to_string(record) + ".")
+                {
+                }
+            };
+
+        private:
+            struct shard
+            {
+                mutable std::shared_mutex mutex;
+                std::unordered_map<name_type, adapter_type> trees;
+            };
+
+        public:
+            explicit tree_store(std::size_t shard_count = default_concurrency() * 4, unsigned threads = default_concurrency())
+                : shards(shard_count ? shard_count : 1), threads(threads ? threads : 1)
+            {
+            }
+
+            bool insert(name_type const &name, adapter_type &&tree)
+            {
+                auto &s = shard_of(name);
+                std::unique_lock lock(s.mutex);
+                return s.trees.try_emplace(name, std::move(tree)).second;
+            }
+            void insert_or_assign(name_type const &name, adapter_type &&tree)
+            {
+                auto &s = shard_of(name);
+                std::unique_lock lock(s.mutex);
+                s.trees.insert_or_assign(name, std::move(tree));
+            }
+            bool erase(name_type const &name)
+            {
+                auto &s = shard_of(name);
+                std::unique_lock lock(s.mutex);
+                return s.trees.erase(name) != 0;
+            }
+            bool contains(name_type const &name) const
+            {
+                auto &s = shard_of(name);
+                std::shared_lock lock(s.mutex);
+                return s.trees.count(name) != 0;
+            }
+            std::size_t size() const
+            {
+                std::size_t result = 0;
+                for (auto &s : shards)
+                {
+                    std::shared_lock lock(s.mutex);
+                    result += s.trees.size();
+                }
+                return result;
+            }
+            std::size_t shard_count() const
+            {
+                return shards.size();
+            }
+
+            template <typename Callable>
+            bool modify(name_type const &name, Callable callable)
+            {
+                auto &s = shard_of(name);
+                std::unique_lock lock(s.mutex);
+                auto found = s.trees.find(name);
+                if (found == s.trees.end())
+                    return false;
+                callable(found->second);
+                return true;
+            }
+            template <typename Callable>
+            bool read(name_type const &name, Callable callable) const
+            {
+                auto &s = shard_of(name);
+                std::shared_lock lock(s.mutex);
+                auto found = s.trees.find(name);
+                if (found == s.trees.end())
+                    return false;
+                callable(static_cast<adapter_type const &>(found->second));
+                return true;
+            }
+
+            template <typename Callable>
+            std::size_t batch(std::vector<name_type> const &names, Callable callable)
+            {
+                std::vector<std::vector<name_type const *>> groups(shards.size());
+                for (auto &name : names)
+                    groups[shard_index(name)].push_back(&name);
+                std::vector<std::size_t> found(shards.size());
+                parallel_for(shards.size(), threads, [&](std::size_t i)
+                {
+                    if (groups[i].empty())
+                        return;
+                    std::unique_lock lock(shards[i].mutex);
+                    for (auto name : groups[i])
+                    {
+                        auto tree = shards[i].trees.find(*name);
+                        if (tree == shards[i].trees.end())
+                            continue;
+                        callable(tree->first, tree->second);
+                        ++found[i];
+                    }
+                });
+                std::size_t result = 0;
+                for (auto count : found)
+                    result += count;
+                return result;
+            }
+            template <typename Callable>
+            void for_each(Callable callable)
+            {
+                parallel_for(shards.size(), threads, [&](std::size_t i)
+                {
+                    std::unique_lock lock(shards[i].mutex);
+                    for (auto &[name, tree] : shards[i].trees)
+                        callable(name, tree);
+                });
+            }
+
+            void save(std::ostream &out) const
+            {
+                std::vector<std::string> dumps(shards.size());
+                parallel_for(shards.size(), threads, [&](std::size_t i)
+                {
+                    std::ostringstream stream, record;
+                    std::shared_lock lock(shards[i].mutex);
+                    for (auto &[name, tree] : shards[i].trees)
+                    {
+                        record.str(std::string{});
+                        record << "(";
+                        escape(record, name, ')', '\\') << ") " << tree;
+                        auto text = record.str();
+                        stream << text.size() << " " << text << "\n";
+                    }
+                    dumps[i] = stream.str();
+                });
+                for (auto &dump : dumps)
+                    out.write(dump.data(), static_cast<std::streamsize>(dump.size()));
+            }
+            std::size_t load(std::istream &in)
+            {
+                std::string text(std::istreambuf_iterator<char>(in), {});
+                std::vector<std::string_view> records;
+                for (std::size_t first = 0; first < text.size();)
+                {
+                    if (text[first] == '\n')
+                    {
+                        ++first;
+                        continue;
+                    }
+                    std::size_t length = 0;
+                    auto digits = std::from_chars(text.data() + first, text.data() + text.size(), length);
+                    auto start = static_cast<std::size_t>(digits.ptr - text.data());
+                    if (digits.ec != std::errc{} || start == text.size() || text[start] != ' ' ||
+                        length > text.size() - start - 1)
+                        throw record_malformed(records.size() + 1);
+                    records.emplace_back(text.data() + start + 1, length);
+                    first = start + 1 + length;
+                    if (first < text.size() && text[first] != '\n')
+                        throw record_malformed(records.size());
+                }
+                constexpr std::size_t block = 256;
+                std::vector<std::vector<std::pair<name_type, adapter_type>>> parsed((records.size() + block - 1) / block);
+                std::vector<std::exception_ptr> errors(parsed.size());
+                parallel_for(parsed.size(), threads, [&](std::size_t b)
+                {
+                    try
+                    {
+                        for (auto i = b * block; i < records.size() && i < (b + 1) * block; ++i)
+                            parsed[b].push_back(parse_record(records[i], i + 1));
+                    }
+                    catch (...)
+                    {
+                        errors[b] = std::current_exception();
+                    }
+                });
+                for (auto &error : errors)
+                    if (error)
+                        std::rethrow_exception(error);
+                std::vector<std::vector<std::pair<name_type, adapter_type> *>> groups(shards.size());
+                for (auto &records_of_block : parsed)
+                    for (auto &record : records_of_block)
+                        groups[shard_index(record.first)].push_back(&record);
+                parallel_for(shards.size(), threads, [&](std::size_t i)
+                {
+                    std::unique_lock lock(shards[i].mutex);
+                    for (auto record : groups[i])
+                        shards[i].trees.insert_or_assign(std::move(record->first), std::move(record->second));
+                });
+                return records.size();
+            }
+
+        private:
+            std::size_t shard_index(name_type const &name) const
+            {
+                return std::hash<name_type>{}(name) % shards.size();
+            }
+            shard &shard_of(name_type const &name)
+            {
+                return shards[shard_index(name)];
+            }
+            shard const &shard_of(name_type const &name) const
+            {
+                return shards[shard_index(name)];
+            }
+
+            static std::pair<name_type, adapter_type> parse_record(std::string_view line, std::size_t number)
+            {
+                if (line.empty() || line.front() != '(')
+                    throw record_malformed(number);
+                name_type name;
+                std::size_t pos = 1;
+                for (; pos < line.size() && line[pos] != ')'; ++pos)
+                {
+                    if (line[pos] == '\\' && pos + 1 < line.size() && (line[pos + 1] == ')' || line[pos + 1] == '\\'))
+                        ++pos;
+                    name.push_back(line[pos]);
+                }
+                if (pos == line.size())
+                    throw record_malformed(number);
+                std::istringstream stream{std::string(line.substr(pos + 1))};
+                adapter_type tree;
+                try
+                {
+                    if (!(stream >> tree))
+                        throw record_malformed(number);
+                }
+                catch (parse::expect_failed const &)
+                {
+                    throw record_malformed(number);
+                }
+                return {std::move(name), std::move(tree)};
+            }
+
+            std::vector<shard> shards;
+            unsigned threads;
+        };
+    }
+}
+
+#endif //INC_201703_TREE_STORE_HPP
@@ -0,0 +1,409 @@
+#ifndef INC_201703_WORKLOAD_HPP
+#define INC_201703_WORKLOAD_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "tree_adapter.hpp"
+#include "operation_trace.hpp"
+
+namespace ds_exp
+{
+    inline namespace workload
+    {
+        struct latency_summary
+        {
+            std::size_t calls = 0;
+            std::uint64_t total_nanoseconds = 0;
+            std::uint64_t p50 = 0, p90 = 0, p99 = 0, max = 0;
+
+            friend std::ostream &operator<<(std::ostream &out, latency_summary const &s)
+            {
+                return out << "calls " << s.calls << ", p50 " << s.p50 << "ns, p90 " << s.p90 << "ns, p99 " << s.p99
+                           << "ns, max " << s.max << "ns";
+            }
+        };
+
+        struct replay_report
+        {
+            std::size_t records = 0;
+            std::size_t failures = 0;
+            std::array<latency_summary, operation_count> operations{};
+
+            double seconds() const
+            {
+                std::uint64_t total = 0;
+                for (auto &op : operations)
+                    total += op.total_nanoseconds;
+                return total / 1e9;
+            }
+            double operations_per_second() const
+            {
+                auto elapsed = seconds();
+                return elapsed > 0 ? records / elapsed : 0;
+            }
+            friend std::ostream &operator<<(std::ostream &out, replay_report const &report)
+            {
+                out << report.records << " records, " << report.failures << " failed, " << report.seconds() << "s, "
+                    << report.operations_per_second() << " ops/s\n";
+                for (std::size_t op = 0; op < operation_count; ++op)
+                {
+                    auto &s = report.operations[op];
+                    if (s.calls)
+                        out << operation_name(static_cast<operation>(op)) << ": " << s << "\n";
+                }
+                return out;
+            }
+        };
+
+        enum class workload_shape
+        {
+            uniform, zipf, insert_heavy, deep_chain
+        };
+
+        namespace detail
+        {
+            template <typename T>
+            T parse_argument(std::string_view text)
+            {
+                T result;
+                if constexpr (std::is_same_v<T, std::string>)
+                    result.assign(text);
+                else
+                    element_parser<T>::parse(text, result);
+                return result;
+            }
+            template <typename Callable>
+            decltype(auto) with_side(std::string_view name, Callable &&callable)
+            {
+                return name == "right" ? callable(right_child) : callable(left_child);
+            }
+            template <typename Callable>
+            decltype(auto) with_order(std::string_view name, Callable &&callable)
+            {
+                if (name == "in")
+                    return callable(inorder);
+                if (name == "post")
+                    return callable(postorder);
+                return callable(preorder);
+            }
+            inline std::string_view argument(trace_record const &record, std::size_t i)
+            {
+                if (i >= record.arguments.size())
+                    throw trace_corrupt("missing argument");
+                return record.arguments[i];
+            }
+            inline latency_summary summarize(std::vector<std::uint64_t> &latencies)
+            {
+                latency_summary summary;
+                if (latencies.empty())
+                    return summary;
+                std::sort(latencies.begin(), latencies.end());
+                auto at = [&](double q)
+                {
+                    return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(q * latencies.size()))];
+                };
+                summary.calls = latencies.size();
+                summary.total_nanoseconds = std::accumulate(latencies.begin(), latencies.end(), std::uint64_t(0));
+                summary.p50 = at(0.5), summary.p90 = at(0.9), summary.p99 = at(0.99), summary.max = latencies.back();
+                return summary;
+            }
+
+            inline void balanced_definition(std::string &out, std::size_t first, std::size_t last)
+            {
+                if (first == last)
+                {
+                    out.append("null");
+                    return;
+                }
+                auto middle = first + (last - first) / 2;
+                out.append("(").append(std::to_string(middle)).append("),");
+                balanced_definition(out, first, middle);
+                out.push_back(',');
+                balanced_definition(out, middle + 1, last);
+            }
+            inline std::string chain_definition(std::size_t keys)
+            {
+                std::string out = "[";
+                for (std::size_t key = 0; key < keys; ++key)
+                    out.append("(").append(std::to_string(key)).append("),");
+                out.append("null");
+                for (std::size_t key = 0; key < keys; ++key)
+                    out.append(",null");
+                return out.append("]");
+            }
+        }
+
+        template <typename Key, typename Value>
+        replay_report replay_trace(std::istream &trace, tree_adapter<Key, Value> &tree)
+        {
+            using adapter_type = tree_adapter<Key, Value>;
+            using key_type = typename adapter_type::key_type;
+            using value_type = typename adapter_type::value_type;
+            using detail::argument;
+            replay_report report;
+            std::array<std::vector<std::uint64_t>, operation_count> latencies;
+            trace_reader reader(trace);
+            trace_record record;
+            std::size_t traversed = 0;
+            auto visit = [&](auto const &)
+            {
+                ++traversed;
+            };
+            while (reader.next(record))
+            {
+                ++report.records;
+                auto start = std::chrono::steady_clock::now();
+                bool succeeded = true;
+                auto timed = [&](auto &&call)
+                {
+                    start = std::chrono::steady_clock::now();
+                    succeeded = call();
+                };
+                try
+                {
+                    switch (record.op)
+                    {
+                    case operation::CreateBiTree:
+                    {
+                        std::istringstream definition{std::string(argument(record, 0))};
+                        timed([&] { tree.CreateBiTree(definition); return true; });
+                        break;
+                    }
+                    case operation::Value:
+                    {
+                        auto key = detail::parse_argument<key_type>(argument(record, 0));
+                        timed([&] { return tree.TryValue(key) != nullptr; });
+                        break;
+                    }
+                    case operation::Assign:
+                    {
+                        auto key = detail::parse_argument<key_type>(argument(record, 0));
+                        auto value = detail::parse_argument<value_type>(argument(record, 1));
+                        timed([&] { return tree.TryAssign(key, std::move(value)); });
+                        break;
+                    }
+                    case operation::Parent:
+                    {
+                        auto key = detail::parse_argument<key_type>(argument(record, 0));
+                        timed([&] { return tree.TryParent(key).has_value(); });
+                        break;
+                    }
+                    case operation::Child:
+                    case operation::Sibling:
+                    {
+                        auto key = detail::parse_argument<key_type>(argument(record, 0));
+                        detail::with_side(argument(record, 1), [&](auto side)
+                        {
+                            if (record.op == operation::Child)
+                                timed([&] { return tree.TryChild(key, side).has_value(); });
+                            else
+                                timed([&] { return tree.TrySibling(key, side).has_value(); });
+                        });
+                        break;
+                    }
+                    case operation::InsertChild:
+                    {
+                        auto key = detail::parse_argument<key_type>(argument(record, 0));
+                        adapter_type inserted;
+                        inserted.CreateBiTree(std::string(argument(record, 2)));
+                        auto position = tree.try_get_iterator(key);
+                        if (!position)
+                        {
+                            succeeded = false;
+                            break;
+                        }
+                        detail::with_side(argument(record, 1), [&](auto side)
+                        {
+                            if (record.arguments.size() < 5)
+                                detail::with_side(argument(record, 3), [&](auto dir)
+                                {
+                                    timed([&] { tree.InsertChild(*position, std::move(inserted), side, dir); return true; });
+                                });
+                            else
+                            {
+                                auto attach_key = detail::parse_argument<key_type>(argument(record, 3));
+                                auto attach = inserted.get_iterator(attach_key);
+                                detail::with_side(argument(record, 4), [&](auto dir)
+                                {
+                                    timed([&] { tree.InsertChild(*position, std::move(inserted), side, attach, dir); return true; });
+                                });
+                            }
+                        });
+                        break;
+                    }
+                    case operation::DeleteChild:
+                    {
+                        auto key = detail::parse_argument<key_type>(argument(record, 0));
+                        auto position = tree.try_get_iterator(key);
+                        if (!position)
+                        {
+                            succeeded = false;
+                            break;
+                        }
+                        detail::with_side(argument(record, 1), [&](auto side)
+                        {
+                            timed([&] { tree.DeleteChild(*position, side); return true; });
+                        });
+                        break;
+                    }
+                    case operation::Traverse:
+                        detail::with_order(argument(record, 0), [&](auto order)
+                        {
+                            detail::with_side(argument(record, 1), [&](auto dir)
+                            {
+                                timed([&] { tree.Traverse(visit, order, dir); return true; });
+                            });
+                        });
+                        break;
+                    case operation::LevelOrderTraverse:
+                        detail::with_side(argument(record, 0), [&](auto dir)
+                        {
+                            timed([&] { tree.LevelOrderTraverse(visit, dir); return true; });
+                        });
+                        break;
+                    default:
+                        throw trace_corrupt("unknown operation");
+                    }
+                }
+                catch (trace_corrupt const &)
+                {
+                    throw;
+                }
+                catch (std::exception const &)
+                {
+                    succeeded = false;
+                }
+                auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                latencies[static_cast<std::size_t>(record.op)].push_back(static_cast<std::uint64_t>(elapsed > 0 ? elapsed : 0));
+                if (!succeeded)
+                    ++report.failures;
+            }
+            for (std::size_t op = 0; op < operation_count; ++op)
+                report.operations[op] = detail::summarize(latencies[op]);
+            return report;
+        }
+
+        template <typename Callable>
+        latency_summary measure_latency(std::size_t calls, Callable &&callable)
+        {
+            std::vector<std::uint64_t> latencies;
+            latencies.reserve(calls);
+            for (std::size_t i = 0; i < calls; ++i)
+            {
+                auto start = std::chrono::steady_clock::now();
+                callable(i);
+                auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                latencies.push_back(static_cast<std::uint64_t>(elapsed > 0 ? elapsed : 0));
+            }
+            return detail::summarize(latencies);
+        }
+
+        inline std::vector<std::string> trace_keys(std::istream &trace, operation op = operation::Value)
+        {
+            std::vector<std::string> keys;
+            trace_reader reader(trace);
+            trace_record record;
+            while (reader.next(record))
+                if (record.op == op && !record.arguments.empty())
+                    keys.push_back(record.arguments.front());
+            return keys;
+        }
+
+        inline std::size_t generate_trace(std::ostream &out, workload_shape shape, std::size_t operations,
+                                          std::size_t keys, std::uint64_t seed = 1, double miss_ratio = 0)
+        {
+            keys = std::max<std::size_t>(keys, 1);
+            std::mt19937_64 random(seed);
+            trace_writer writer(out);
+            trace_record record;
+            std::size_t written = 0;
+            auto emit = [&](operation op, std::vector<std::string> arguments)
+            {
+                record.op = op;
+                record.nanoseconds = written * 1000;
+                record.arguments = std::move(arguments);
+                writer.write(record);
+                ++written;
+            };
+            auto side = [&]
+            {
+                return std::string(random() & 1 ? "right" : "left");
+            };
+
+            std::string definition;
+            if (shape == workload_shape::deep_chain)
+                definition = detail::chain_definition(keys);
+            else
+            {
+                definition = "[";
+                detail::balanced_definition(definition, 0, keys);
+                definition.push_back(']');
+            }
+            emit(operation::CreateBiTree, {definition});
+
+            std::vector<std::size_t> ranks(keys);
+            std::iota(ranks.begin(), ranks.end(), std::size_t(0));
+            std::shuffle(ranks.begin(), ranks.end(), random);
+            std::vector<double> weights(keys);
+            for (std::size_t i = 0; i < keys; ++i)
+                weights[i] = 1.0 / static_cast<double>(i + 1);
+            std::discrete_distribution<std::size_t> zipf(weights.begin(), weights.end());
+            std::uniform_int_distribution<std::size_t> percent(0, 99);
+            std::bernoulli_distribution miss(std::clamp(miss_ratio, 0.0, 1.0));
+            std::size_t key_count = keys, root = shape == workload_shape::deep_chain ? 0 : keys / 2;
+            auto pick = [&]
+            {
+                switch (shape)
+                {
+                case workload_shape::zipf:
+                    return ranks[zipf(random)];
+                case workload_shape::deep_chain:
+                    return keys - 1 - std::min(keys - 1, std::uniform_int_distribution<std::size_t>(0, keys / 8)(random));
+                default:
+                    return std::uniform_int_distribution<std::size_t>(0, key_count - 1)(random);
+                }
+            };
+
+            for (std::size_t i = 0; i < operations; ++i)
+            {
+                auto roll = percent(random);
+                if (shape == workload_shape::insert_heavy && roll < 70)
+                {
+                    auto position = std::to_string(pick());
+                    auto inserted = "[(" + std::to_string(key_count++) + "),null,null]";
+                    emit(operation::InsertChild, {position, side(), inserted, "right"});
+                } else if (i % 1000 == 999)
+                    emit(operation::Traverse, {"in", "left"});
+                else
+                {
+                    auto key = std::to_string(miss_ratio > 0 && miss(random) ? keys + operations + pick() : pick());
+                    auto at_root = key == std::to_string(root);
+                    if (roll < 60 || shape == workload_shape::insert_heavy || (roll < 75 && at_root))
+                        emit(operation::Value, {key});
+                    else if (roll < 75)
+                        emit(operation::Parent, {key});
+                    else if (roll < 90 || at_root)
+                        emit(operation::Child, {key, side()});
+                    else
+                        emit(operation::Sibling, {key, side()});
+                }
+            }
+            return written;
+        }
+    }
+}
+
+#endif //INC_201703_WORKLOAD_HPP